@@ -0,0 +1,126 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+// Simulates thousands of orbiting hammers over a number of frames with the engine free hammer math
+// and reports the cost per hammer and frame, outside of the editor.
+// The game module compiles every source under its directory, the define set by Benchmarks/CMakeLists.txt keeps this file out of it.
+
+#if defined(RPG_HAMMER_STANDALONE_BENCHMARK)
+
+#include "RPGHammerOrbitMath.h"
+#include "RPGHammerFormation.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+	/**Minimal vector with the members the hammer math expects*/
+	struct FBenchVector
+	{
+		float X;
+		float Y;
+		float Z;
+
+		FBenchVector(const float InX, const float InY, const float InZ)
+			: X(InX), Y(InY), Z(InZ)
+		{
+		}
+	};
+
+	using FBenchOrbitState = RPGHammerOrbitMath::TOrbitState<float, FBenchVector>;
+	using FBenchOrbitProfile = RPGHammerOrbitMath::TOrbitProfile<float>;
+
+	/**Seconds spent by the callable*/
+	template<typename CallableType>
+	double MeasureSeconds(CallableType&& Callable)
+	{
+		const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+		Callable();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+	}
+
+	/**Orbit step of every hammer: ease, advance the angle and compute the offset from the player*/
+	double BenchOrbit(const int NumHammers, const int NumFrames, float& OutChecksum)
+	{
+		const FBenchOrbitProfile OrbitProfile;
+		const FBenchOrbitProfile SpinningProfile = RPGHammerOrbitMath::MakeSpinningProfile(OrbitProfile);
+		const float DeltaSeconds = 1.f / 60.f;
+
+		std::vector<FBenchOrbitState> States(NumHammers);
+		for (int HammerIndex = 0; HammerIndex < NumHammers; HammerIndex++)
+		{
+			States[HammerIndex].RotationAngleAxis = RPGHammerFormation::InitialSlotAngle(HammerIndex, NumHammers);
+			States[HammerIndex].bIsInSpinningMode = HammerIndex % 8 == 0;
+		}
+
+		float Checksum = 0.f;
+		const double Seconds = MeasureSeconds([&]()
+		{
+			for (int Frame = 0; Frame < NumFrames; Frame++)
+			{
+				//The player turns slowly so the orbit alternates between expanding and contracting
+				const float PlayerYaw = RPGHammerOrbitMath::DegreesToRadians(static_cast<float>(Frame % 360));
+				const FBenchVector OwnerForwardVector(std::cos(PlayerYaw), std::sin(PlayerYaw), 0.f);
+				const FBenchVector OwnerRightVector(-std::sin(PlayerYaw), std::cos(PlayerYaw), 0.f);
+
+				for (FBenchOrbitState& State : States)
+				{
+					RPGHammerOrbitMath::EaseOrbit(State, State.bIsInSpinningMode ? SpinningProfile : OrbitProfile, OwnerForwardVector, OwnerRightVector);
+					State.RotationAngleAxis = RPGHammerOrbitMath::AdvanceAngle(State.RotationAngleAxis, State.RotationSpeed, State.RotationDirection, DeltaSeconds);
+					const FBenchVector OrbitOffset = RPGHammerOrbitMath::OrbitOffsetAboutZ<FBenchVector>(State.RotationRadius, State.RotationAngleAxis);
+					Checksum += OrbitOffset.X + OrbitOffset.Y;
+				}
+			}
+		});
+
+		OutChecksum += Checksum;
+		return Seconds;
+	}
+
+	/**Re-layout of the remaining formation after every single use until one hammer is left*/
+	double BenchRelayout(const int NumHammers, float& OutChecksum)
+	{
+		float Checksum = 0.f;
+		const double Seconds = MeasureSeconds([&]()
+		{
+			for (int RemainingNumberOfHammers = NumHammers - 1; RemainingNumberOfHammers > 0; RemainingNumberOfHammers--)
+			{
+				for (int RankIndex = 0; RankIndex < RemainingNumberOfHammers; RankIndex++)
+				{
+					Checksum += RPGHammerFormation::RelayoutAngleOffset(RankIndex + 1, RemainingNumberOfHammers, RankIndex % 2 == 0 ? 1.f : -1.f);
+				}
+			}
+		});
+
+		OutChecksum += Checksum;
+		return Seconds;
+	}
+}
+
+int main(int ArgumentCount, char** Arguments)
+{
+	const int NumHammers = ArgumentCount > 1 ? std::atoi(Arguments[1]) : 4096;
+	const int NumFrames = ArgumentCount > 2 ? std::atoi(Arguments[2]) : 600;
+	if (NumHammers <= 0 || NumFrames <= 0)
+	{
+		std::fprintf(stderr, "Usage: %s [NumHammers > 0] [NumFrames > 0]\n", Arguments[0]);
+		return 1;
+	}
+
+	//Printed so the compiler cannot drop the simulated work
+	float Checksum = 0.f;
+
+	const double OrbitSeconds = BenchOrbit(NumHammers, NumFrames, Checksum);
+	const double RelayoutSeconds = BenchRelayout(NumHammers, Checksum);
+	const double NumRelayoutUpdates = static_cast<double>(NumHammers) * static_cast<double>(NumHammers - 1) / 2.0;
+
+	std::printf("Hammers: %d, frames: %d\n", NumHammers, NumFrames);
+	std::printf("Orbit:    %.2f ns/hammer/frame\n", OrbitSeconds * 1.e9 / (static_cast<double>(NumHammers) * NumFrames));
+	std::printf("Relayout: %.2f ns/hammer update (%d single uses)\n", NumRelayoutUpdates > 0.0 ? RelayoutSeconds * 1.e9 / NumRelayoutUpdates : 0.0, NumHammers - 1);
+	std::printf("Checksum: %f\n", Checksum);
+	return 0;
+}
+
+#endif //RPG_HAMMER_STANDALONE_BENCHMARK
@@ -0,0 +1,121 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SergioTestContentClasses/RPGAttributeWatcherSubsystem.h"
+#include "AbilitySystemComponent.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGAttributeWatcherSubsystem::Deinitialize()
+{
+	for (const TPair<FRPGWatchedAttributeKey, FRPGWatchedAttribute>& WatchedAttributePair : WatchedAttributes)
+	{
+		UnbindAttribute(WatchedAttributePair.Key, WatchedAttributePair.Value);
+	}
+	WatchedAttributes.Empty();
+
+	Super::Deinitialize();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGAttributeWatcherSubsystem::WatchAttributeThreshold(UAbilitySystemComponent* AbilitySystem, const FGameplayAttribute& Attribute, const float Threshold, const ERPGAttributeThresholdCrossing Crossing,
+	const UObject* WatcherOwner, FOnRPGAttributeThresholdCrossed OnCrossed, const bool bOnlyGameplayEffectChanges)
+{
+	if (!IsValid(AbilitySystem) || !Attribute.IsValid() || !OnCrossed.IsBound())
+	{
+		return;
+	}
+
+	FRPGWatchedAttributeKey Key;
+	Key.AbilitySystem = AbilitySystem;
+	Key.Attribute = Attribute;
+
+	//Only the first watcher of the attribute binds to the ability system
+	FRPGWatchedAttribute& WatchedAttribute = WatchedAttributes.FindOrAdd(Key);
+	if (!WatchedAttribute.ValueChangeHandle.IsValid())
+	{
+		WatchedAttribute.ValueChangeHandle = AbilitySystem->GetGameplayAttributeValueChangeDelegate(Attribute).AddUObject(this, &URPGAttributeWatcherSubsystem::OnAttributeValueChanged, Key);
+	}
+
+	FRPGAttributeThresholdWatch& NewWatch = WatchedAttribute.Watches.AddDefaulted_GetRef();
+	NewWatch.WatcherOwner = WatcherOwner;
+	NewWatch.Threshold = Threshold;
+	NewWatch.Crossing = Crossing;
+	NewWatch.bOnlyGameplayEffectChanges = bOnlyGameplayEffectChanges;
+	NewWatch.OnCrossed = MoveTemp(OnCrossed);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGAttributeWatcherSubsystem::RemoveWatchers(const UObject* WatcherOwner)
+{
+	for (auto WatchedAttributeIterator = WatchedAttributes.CreateIterator(); WatchedAttributeIterator; ++WatchedAttributeIterator)
+	{
+		FRPGWatchedAttribute& WatchedAttribute = WatchedAttributeIterator.Value();
+		WatchedAttribute.Watches.RemoveAllSwap([WatcherOwner](const FRPGAttributeThresholdWatch& Watch)
+		{
+			return Watch.WatcherOwner == WatcherOwner || !Watch.WatcherOwner.IsValid();
+		});
+
+		if (WatchedAttribute.Watches.Num() == 0)
+		{
+			UnbindAttribute(WatchedAttributeIterator.Key(), WatchedAttribute);
+			WatchedAttributeIterator.RemoveCurrent();
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGAttributeWatcherSubsystem::OnAttributeValueChanged(const FOnAttributeChangeData& AttributeData, FRPGWatchedAttributeKey Key)
+{
+	const FRPGWatchedAttribute* WatchedAttribute = WatchedAttributes.Find(Key);
+	if (!WatchedAttribute)
+	{
+		return;
+	}
+
+	//The callbacks can remove watchers, so the crossed ones are collected before calling any of them
+	TArray<FOnRPGAttributeThresholdCrossed, TInlineAllocator<4>> CrossedCallbacks;
+	for (const FRPGAttributeThresholdWatch& Watch : WatchedAttribute->Watches)
+	{
+		if (!Watch.WatcherOwner.IsValid() || (Watch.bOnlyGameplayEffectChanges && AttributeData.GEModData == nullptr))
+		{
+			continue;
+		}
+
+		if (HasCrossedThreshold(Watch, AttributeData.OldValue, AttributeData.NewValue))
+		{
+			CrossedCallbacks.Add(Watch.OnCrossed);
+		}
+	}
+
+	for (const FOnRPGAttributeThresholdCrossed& CrossedCallback : CrossedCallbacks)
+	{
+		CrossedCallback.ExecuteIfBound(AttributeData.NewValue);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGAttributeWatcherSubsystem::HasCrossedThreshold(const FRPGAttributeThresholdWatch& Watch, const float OldValue, const float NewValue)
+{
+	if (Watch.Crossing == ERPGAttributeThresholdCrossing::FallsToOrBelow)
+	{
+		return OldValue > Watch.Threshold && NewValue <= Watch.Threshold;
+	}
+
+	return OldValue < Watch.Threshold && NewValue >= Watch.Threshold;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGAttributeWatcherSubsystem::UnbindAttribute(const FRPGWatchedAttributeKey& Key, const FRPGWatchedAttribute& WatchedAttribute) const
+{
+	UAbilitySystemComponent* AbilitySystem = Key.AbilitySystem.Get();
+	if (IsValid(AbilitySystem) && WatchedAttribute.ValueChangeHandle.IsValid())
+	{
+		AbilitySystem->GetGameplayAttributeValueChangeDelegate(Key.Attribute).Remove(WatchedAttribute.ValueChangeHandle);
+	}
+}
@@ -0,0 +1,100 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AttributeSet.h"
+#include "RPGAttributeWatcherSubsystem.generated.h"
+
+class UAbilitySystemComponent;
+struct FOnAttributeChangeData;
+
+/**Side of the threshold that triggers the watcher*/
+UENUM(BlueprintType)
+enum class ERPGAttributeThresholdCrossing : uint8
+{
+	/**The value was above the threshold and now is lower or equal*/
+	FallsToOrBelow,
+	/**The value was below the threshold and now is greater or equal*/
+	RisesToOrAbove,
+};
+
+/**Called once per crossing with the new attribute value*/
+DECLARE_DELEGATE_OneParam(FOnRPGAttributeThresholdCrossed, float /*NewValue*/);
+
+/**A single watcher of an attribute*/
+struct FRPGAttributeThresholdWatch
+{
+	/**Object that registered the watcher, the watcher is dropped when it is no longer valid*/
+	TWeakObjectPtr<const UObject> WatcherOwner;
+
+	float Threshold = 0.f;
+
+	ERPGAttributeThresholdCrossing Crossing = ERPGAttributeThresholdCrossing::FallsToOrBelow;
+
+	/**Ignore the changes that do not come from a gameplay effect execution, like the replicated values on clients*/
+	bool bOnlyGameplayEffectChanges = false;
+
+	FOnRPGAttributeThresholdCrossed OnCrossed;
+};
+
+/**Attribute of an ability system component*/
+struct FRPGWatchedAttributeKey
+{
+	TWeakObjectPtr<UAbilitySystemComponent> AbilitySystem;
+
+	FGameplayAttribute Attribute;
+
+	bool operator==(const FRPGWatchedAttributeKey& Other) const { return AbilitySystem == Other.AbilitySystem && Attribute == Other.Attribute; }
+
+	friend uint32 GetTypeHash(const FRPGWatchedAttributeKey& Key) { return HashCombine(GetTypeHash(Key.AbilitySystem), GetTypeHash(Key.Attribute)); }
+};
+
+/**The single delegate binding of an attribute and every watcher sharing it*/
+struct FRPGWatchedAttribute
+{
+	FDelegateHandle ValueChangeHandle;
+
+	TArray<FRPGAttributeThresholdWatch> Watches;
+};
+
+/**
+ * Fires callbacks only when an attribute crosses a threshold instead of on every change of its value.
+ * All the watchers of the same attribute share one binding to the attribute value change delegate,
+ * the binding is removed with the last watcher so nothing is left bound between ability activations.
+ */
+UCLASS()
+class ACTIONRPG_API URPGAttributeWatcherSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin USubsystem Interface
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	/**Call OnCrossed every time the attribute crosses the threshold, until the watchers of WatcherOwner are removed*/
+	void WatchAttributeThreshold(UAbilitySystemComponent* AbilitySystem, const FGameplayAttribute& Attribute, const float Threshold, const ERPGAttributeThresholdCrossing Crossing,
+		const UObject* WatcherOwner, FOnRPGAttributeThresholdCrossed OnCrossed, const bool bOnlyGameplayEffectChanges = false);
+
+	/**Remove every watcher registered by WatcherOwner and unbind the attributes left without watchers*/
+	void RemoveWatchers(const UObject* WatcherOwner);
+
+	/**Number of attribute value change delegates currently bound*/
+	int32 GetNumBoundAttributes() const { return WatchedAttributes.Num(); }
+
+protected:
+
+	/**Shared callback of every watched attribute*/
+	void OnAttributeValueChanged(const FOnAttributeChangeData& AttributeData, FRPGWatchedAttributeKey Key);
+
+	/**Does the change from OldValue to NewValue cross the threshold of the watcher*/
+	static bool HasCrossedThreshold(const FRPGAttributeThresholdWatch& Watch, const float OldValue, const float NewValue);
+
+	/**Remove the delegate binding of the attribute*/
+	void UnbindAttribute(const FRPGWatchedAttributeKey& Key, const FRPGWatchedAttribute& WatchedAttribute) const;
+
+	TMap<FRPGWatchedAttributeKey, FRPGWatchedAttribute> WatchedAttributes;
+};
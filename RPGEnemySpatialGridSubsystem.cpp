@@ -0,0 +1,293 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SergioTestContentClasses/RPGEnemySpatialGridSubsystem.h"
+#include "SergioTestContentClasses/RPGFactionComponent.h"
+#include "RPGCharacterBase.h"
+#include "EngineUtils.h"
+
+static TAutoConsoleVariable<float> CVarRPGEnemyGridCellSize(
+	TEXT("RPG.EnemyGrid.CellSize"),
+	1000.f,
+	TEXT("Size in world units of the cells of the enemy spatial grid, read when the world is created."),
+	ECVF_Default);
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGEnemySpatialGridSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	CellSize = FMath::Max(CVarRPGEnemyGridCellSize.GetValueOnGameThread(), 100.f);
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &URPGEnemySpatialGridSubsystem::OnActorSpawned));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGEnemySpatialGridSubsystem::Deinitialize()
+{
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+
+	GridEntries.Empty();
+	GridCells.Empty();
+	EntryIndexByCharacter.Empty();
+
+	Super::Deinitialize();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGEnemySpatialGridSubsystem::Tick(float DeltaTime)
+{
+	if (!bHasGatheredLevelCharacters)
+	{
+		GatherLevelCharacters();
+	}
+
+	TArray<int32, TInlineAllocator<16>> StaleEntryIndices;
+	for (auto EntryIterator = GridEntries.CreateIterator(); EntryIterator; ++EntryIterator)
+	{
+		if (!RefreshEntry(EntryIterator.GetIndex()))
+		{
+			StaleEntryIndices.Add(EntryIterator.GetIndex());
+		}
+	}
+
+	for (const int32 StaleEntryIndex : StaleEntryIndices)
+	{
+		RemoveEntry(StaleEntryIndex);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+ETickableTickType URPGEnemySpatialGridSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Always;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+TStatId URPGEnemySpatialGridSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(URPGEnemySpatialGridSubsystem, STATGROUP_Tickables);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGEnemySpatialGridSubsystem::RegisterCharacter(ARPGCharacterBase* Character)
+{
+	if (!IsValid(Character) || EntryIndexByCharacter.Contains(Character))
+	{
+		return;
+	}
+
+	FRPGSpatialGridEntry NewEntry;
+	NewEntry.Character = Character;
+	NewEntry.FactionComponent = URPGFactionComponent::FindOrAddFactionComponent(Character);
+	NewEntry.CachedLocation = Character->GetActorLocation();
+	NewEntry.Cell = GetCellFromLocation(NewEntry.CachedLocation);
+
+	const int32 EntryIndex = GridEntries.Add(NewEntry);
+	GridCells.FindOrAdd(NewEntry.Cell).Add(EntryIndex);
+	EntryIndexByCharacter.Add(Character, EntryIndex);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGEnemySpatialGridSubsystem::UnregisterCharacter(ARPGCharacterBase* Character)
+{
+	const int32* EntryIndex = EntryIndexByCharacter.Find(Character);
+	if (EntryIndex)
+	{
+		RemoveEntry(*EntryIndex);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+ARPGCharacterBase* URPGEnemySpatialGridSubsystem::FindNearestCharacter(const FVector& Origin, const float Radius, const ERPGFactionFlags RequiredFactionFlags, const TSet<const AActor*>& ExcludedActors, TFunctionRef<bool(const ARPGCharacterBase*)> Predicate) const
+{
+	const FIntPoint OriginCell = GetCellFromLocation(Origin);
+	const int32 MaxRing = FMath::CeilToInt(Radius / CellSize);
+
+	ARPGCharacterBase* NearestCharacter = nullptr;
+	float NearestDistanceSquared = FMath::Square(Radius);
+
+	for (int32 Ring = 0; Ring <= MaxRing; Ring++)
+	{
+		//Every cell of this ring is at least (Ring - 1) cells away from the origin
+		const float RingMinDistance = FMath::Max(Ring - 1, 0) * CellSize;
+		if (NearestCharacter && FMath::Square(RingMinDistance) > NearestDistanceSquared)
+		{
+			break;
+		}
+
+		for (int32 OffsetX = -Ring; OffsetX <= Ring; OffsetX++)
+		{
+			//Inner rows only have the two border cells of the ring
+			const bool bIsBorderRow = FMath::Abs(OffsetX) == Ring;
+			const int32 StepY = bIsBorderRow ? 1 : FMath::Max(Ring * 2, 1);
+			for (int32 OffsetY = -Ring; OffsetY <= Ring; OffsetY += StepY)
+			{
+				const TArray<int32>* CellEntries = GridCells.Find(FIntPoint(OriginCell.X + OffsetX, OriginCell.Y + OffsetY));
+				if (!CellEntries)
+				{
+					continue;
+				}
+
+				for (const int32 EntryIndex : *CellEntries)
+				{
+					const FRPGSpatialGridEntry& GridEntry = GridEntries[EntryIndex];
+					const float DistanceSquared = FVector::DistSquared(Origin, GridEntry.CachedLocation);
+					if (DistanceSquared >= NearestDistanceSquared)
+					{
+						continue;
+					}
+
+					const URPGFactionComponent* CandidateFaction = GridEntry.FactionComponent.Get();
+					if (!CandidateFaction || !CandidateFaction->HasAllFactionFlags(RequiredFactionFlags))
+					{
+						continue;
+					}
+
+					ARPGCharacterBase* Candidate = GridEntry.Character.Get();
+					const bool bValidCandidate = IsValid(Candidate) && !ExcludedActors.Contains(Candidate) && Predicate(Candidate);
+					if (bValidCandidate)
+					{
+						NearestCharacter = Candidate;
+						NearestDistanceSquared = DistanceSquared;
+					}
+				}
+			}
+		}
+	}
+
+	return NearestCharacter;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGEnemySpatialGridSubsystem::GatherCharacters(const FVector& Origin, const float Radius, const ERPGFactionFlags RequiredFactionFlags, const TSet<const AActor*>& ExcludedActors, TFunctionRef<bool(const ARPGCharacterBase*)> Predicate, TArray<ARPGCharacterBase*>& OutCharacters) const
+{
+	const FIntPoint MinCell = GetCellFromLocation(Origin - FVector(Radius, Radius, 0.f));
+	const FIntPoint MaxCell = GetCellFromLocation(Origin + FVector(Radius, Radius, 0.f));
+	const float RadiusSquared = FMath::Square(Radius);
+
+	for (int32 CellX = MinCell.X; CellX <= MaxCell.X; CellX++)
+	{
+		for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; CellY++)
+		{
+			const TArray<int32>* CellEntries = GridCells.Find(FIntPoint(CellX, CellY));
+			if (!CellEntries)
+			{
+				continue;
+			}
+
+			for (const int32 EntryIndex : *CellEntries)
+			{
+				const FRPGSpatialGridEntry& GridEntry = GridEntries[EntryIndex];
+				if (FVector::DistSquared(Origin, GridEntry.CachedLocation) > RadiusSquared)
+				{
+					continue;
+				}
+
+				const URPGFactionComponent* CandidateFaction = GridEntry.FactionComponent.Get();
+				if (!CandidateFaction || !CandidateFaction->HasAllFactionFlags(RequiredFactionFlags))
+				{
+					continue;
+				}
+
+				ARPGCharacterBase* Candidate = GridEntry.Character.Get();
+				const bool bValidCandidate = IsValid(Candidate) && !ExcludedActors.Contains(Candidate) && Predicate(Candidate);
+				if (bValidCandidate)
+				{
+					OutCharacters.Add(Candidate);
+				}
+			}
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGEnemySpatialGridSubsystem::OnActorSpawned(AActor* SpawnedActor)
+{
+	ARPGCharacterBase* SpawnedCharacter = Cast<ARPGCharacterBase>(SpawnedActor);
+	if (SpawnedCharacter)
+	{
+		RegisterCharacter(SpawnedCharacter);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGEnemySpatialGridSubsystem::GatherLevelCharacters()
+{
+	for (TActorIterator<ARPGCharacterBase> CharacterIterator(GetWorld()); CharacterIterator; ++CharacterIterator)
+	{
+		RegisterCharacter(*CharacterIterator);
+	}
+
+	bHasGatheredLevelCharacters = true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGEnemySpatialGridSubsystem::RefreshEntry(const int32 EntryIndex)
+{
+	FRPGSpatialGridEntry& GridEntry = GridEntries[EntryIndex];
+	const ARPGCharacterBase* Character = GridEntry.Character.Get();
+	if (!IsValid(Character))
+	{
+		return false;
+	}
+
+	GridEntry.CachedLocation = Character->GetActorLocation();
+	const FIntPoint NewCell = GetCellFromLocation(GridEntry.CachedLocation);
+	if (NewCell == GridEntry.Cell)
+	{
+		return true;
+	}
+
+	TArray<int32>* OldCellEntries = GridCells.Find(GridEntry.Cell);
+	if (OldCellEntries)
+	{
+		OldCellEntries->RemoveSingleSwap(EntryIndex, false);
+		if (OldCellEntries->Num() == 0)
+		{
+			GridCells.Remove(GridEntry.Cell);
+		}
+	}
+
+	GridEntry.Cell = NewCell;
+	GridCells.FindOrAdd(NewCell).Add(EntryIndex);
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGEnemySpatialGridSubsystem::RemoveEntry(const int32 EntryIndex)
+{
+	const FRPGSpatialGridEntry& GridEntry = GridEntries[EntryIndex];
+
+	TArray<int32>* CellEntries = GridCells.Find(GridEntry.Cell);
+	if (CellEntries)
+	{
+		CellEntries->RemoveSingleSwap(EntryIndex, false);
+		if (CellEntries->Num() == 0)
+		{
+			GridCells.Remove(GridEntry.Cell);
+		}
+	}
+
+	EntryIndexByCharacter.Remove(GridEntry.Character);
+	GridEntries.RemoveAt(EntryIndex);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+FIntPoint URPGEnemySpatialGridSubsystem::GetCellFromLocation(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
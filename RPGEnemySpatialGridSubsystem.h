@@ -0,0 +1,99 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "RPGEnemySpatialGridSubsystem.generated.h"
+
+class ARPGCharacterBase;
+class URPGFactionComponent;
+enum class ERPGFactionFlags : uint8;
+
+/**A character tracked by the grid and the cell where it was last seen*/
+struct FRPGSpatialGridEntry
+{
+	TWeakObjectPtr<ARPGCharacterBase> Character;
+
+	/**Faction of the character cached at registration so the queries filter with a bit test*/
+	TWeakObjectPtr<URPGFactionComponent> FactionComponent;
+
+	/**Location refreshed every grid update, used by the queries to avoid touching the actor*/
+	FVector CachedLocation = FVector::ZeroVector;
+
+	FIntPoint Cell = FIntPoint::ZeroValue;
+};
+
+/**
+ * Spatial hash of every ARPGCharacterBase in the world, incrementally maintained:
+ * characters only move between buckets when they cross a cell border.
+ * Used by the abilities to find the nearest valid enemy without a physics overlap.
+ */
+UCLASS()
+class ACTIONRPG_API URPGEnemySpatialGridSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin USubsystem Interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	//~ End FTickableGameObject Interface
+
+	/**Start tracking the character, characters spawned after the world begins are registered automatically*/
+	void RegisterCharacter(ARPGCharacterBase* Character);
+
+	/**Stop tracking the character*/
+	void UnregisterCharacter(ARPGCharacterBase* Character);
+
+	/**
+	 * Nearest tracked character inside the radius with all the required faction flags that is not excluded and passes the predicate, nullptr if there is none.
+	 * The cells are visited in rings around the origin and the search stops as soon as no closer character can exist.
+	 */
+	ARPGCharacterBase* FindNearestCharacter(const FVector& Origin, const float Radius, const ERPGFactionFlags RequiredFactionFlags, const TSet<const AActor*>& ExcludedActors, TFunctionRef<bool(const ARPGCharacterBase*)> Predicate) const;
+
+	/**Every tracked character inside the radius with all the required faction flags that is not excluded and passes the predicate, in no particular order*/
+	void GatherCharacters(const FVector& Origin, const float Radius, const ERPGFactionFlags RequiredFactionFlags, const TSet<const AActor*>& ExcludedActors, TFunctionRef<bool(const ARPGCharacterBase*)> Predicate, TArray<ARPGCharacterBase*>& OutCharacters) const;
+
+	int32 GetNumTrackedCharacters() const { return GridEntries.Num(); }
+
+protected:
+
+	/**Called for every actor spawned in the world*/
+	void OnActorSpawned(AActor* SpawnedActor);
+
+	/**Register the characters already placed in the levels*/
+	void GatherLevelCharacters();
+
+	/**Move the entry to the bucket of its current cell, returns false if the character is no longer valid*/
+	bool RefreshEntry(const int32 EntryIndex);
+
+	void RemoveEntry(const int32 EntryIndex);
+
+	FIntPoint GetCellFromLocation(const FVector& Location) const;
+
+	/**Stable indices of the tracked characters*/
+	TSparseArray<FRPGSpatialGridEntry> GridEntries;
+
+	/**Entry indices of every occupied cell*/
+	TMap<FIntPoint, TArray<int32>> GridCells;
+
+	/**Entry index of each tracked character*/
+	TMap<TWeakObjectPtr<ARPGCharacterBase>, int32> EntryIndexByCharacter;
+
+	/**Size in world units of a cell side*/
+	float CellSize = 1000.f;
+
+	bool bHasGatheredLevelCharacters = false;
+
+	FDelegateHandle ActorSpawnedHandle;
+};
@@ -0,0 +1,120 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SergioTestContentClasses/RPGFactionComponent.h"
+#include "GameFramework/Actor.h"
+
+namespace RPGFactionTags
+{
+	static const FName Player(TEXT("Player"));
+	static const FName Enemy(TEXT("Enemy"));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+URPGFactionComponent::URPGFactionComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	FactionMask = 0;
+	FactionMaskBeforeControl = 0;
+	bMirrorToActorTags = true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+URPGFactionComponent* URPGFactionComponent::FindOrAddFactionComponent(AActor* Actor)
+{
+	if (!IsValid(Actor))
+	{
+		return nullptr;
+	}
+
+	URPGFactionComponent* FactionComponent = Actor->FindComponentByClass<URPGFactionComponent>();
+	if (FactionComponent)
+	{
+		return FactionComponent;
+	}
+
+	FactionComponent = NewObject<URPGFactionComponent>(Actor);
+	FactionComponent->RegisterComponent();
+
+	//Bootstrap the mask from the tags the actor was authored with
+	uint8 InitialFactionMask = 0;
+	if (Actor->ActorHasTag(RPGFactionTags::Player))
+	{
+		InitialFactionMask |= static_cast<uint8>(ERPGFactionFlags::Player);
+	}
+	if (Actor->ActorHasTag(RPGFactionTags::Enemy))
+	{
+		InitialFactionMask |= static_cast<uint8>(ERPGFactionFlags::Enemy);
+	}
+	FactionComponent->FactionMask = InitialFactionMask;
+
+	return FactionComponent;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGFactionComponent::SetFactionMask(const uint8 NewFactionMask)
+{
+	if (NewFactionMask == FactionMask)
+	{
+		return;
+	}
+
+	const uint8 OldFactionMask = FactionMask;
+	FactionMask = NewFactionMask;
+
+	if (bMirrorToActorTags)
+	{
+		MirrorFactionToActorTags();
+	}
+
+	OnFactionChanged.Broadcast(this, OldFactionMask, FactionMask);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGFactionComponent::SetControlledByPlayer(const bool bIsControlled)
+{
+	const bool bWasControlled = HasAnyFactionFlags(ERPGFactionFlags::Controlled);
+	if (bIsControlled == bWasControlled)
+	{
+		return;
+	}
+
+	if (bIsControlled)
+	{
+		FactionMaskBeforeControl = FactionMask;
+		SetFactionMask(static_cast<uint8>(ERPGFactionFlags::Player | ERPGFactionFlags::Controlled));
+	}
+	else
+	{
+		SetFactionMask(FactionMaskBeforeControl);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGFactionComponent::MirrorFactionToActorTags() const
+{
+	AActor* Owner = GetOwner();
+	if (!IsValid(Owner))
+	{
+		return;
+	}
+
+	Owner->Tags.Remove(RPGFactionTags::Player);
+	Owner->Tags.Remove(RPGFactionTags::Enemy);
+
+	//Inserted first so the systems that still read Tags[0] keep working
+	if (HasAnyFactionFlags(ERPGFactionFlags::Enemy))
+	{
+		Owner->Tags.Insert(RPGFactionTags::Enemy, 0);
+	}
+	if (HasAnyFactionFlags(ERPGFactionFlags::Player))
+	{
+		Owner->Tags.Insert(RPGFactionTags::Player, 0);
+	}
+}
@@ -0,0 +1,79 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "RPGFactionComponent.generated.h"
+
+/**Allegiance bits of an actor*/
+UENUM(BlueprintType, meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class ERPGFactionFlags : uint8
+{
+	None = 0 UMETA(Hidden),
+	Player = 1 << 0,
+	Enemy = 1 << 1,
+	/**The actor fights for a faction that is not its original one*/
+	Controlled = 1 << 2,
+};
+ENUM_CLASS_FLAGS(ERPGFactionFlags);
+
+class URPGFactionComponent;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnRPGFactionChanged, URPGFactionComponent*, FactionComponent, uint8, OldFactionMask, uint8, NewFactionMask);
+
+/**
+ * Native allegiance of an actor stored as a compact bitmask.
+ * Replaces reading and writing the "Enemy"/"Player" FName in Tags[0], the tags are only mirrored for the systems that still read them.
+ */
+UCLASS(ClassGroup = (RPG), meta = (BlueprintSpawnableComponent))
+class ACTIONRPG_API URPGFactionComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	URPGFactionComponent();
+
+	/**Faction component of the actor, created from its "Enemy"/"Player" tags when the actor does not have one*/
+	UFUNCTION(BlueprintCallable, Category = "Faction")
+	static URPGFactionComponent* FindOrAddFactionComponent(AActor* Actor);
+
+	UFUNCTION(BlueprintCallable, Category = "Faction")
+	uint8 GetFactionMask() const { return FactionMask; }
+
+	UFUNCTION(BlueprintCallable, Category = "Faction")
+	void SetFactionMask(const uint8 NewFactionMask);
+
+	bool HasAnyFactionFlags(const ERPGFactionFlags Flags) const { return (FactionMask & static_cast<uint8>(Flags)) != 0; }
+
+	bool HasAllFactionFlags(const ERPGFactionFlags Flags) const { return (FactionMask & static_cast<uint8>(Flags)) == static_cast<uint8>(Flags); }
+
+	/**Is this actor currently fighting against the players*/
+	UFUNCTION(BlueprintCallable, Category = "Faction")
+	bool IsHostile() const { return HasAnyFactionFlags(ERPGFactionFlags::Enemy); }
+
+	/**An enemy becomes an ally of the players while controlled and returns to its original faction when released*/
+	UFUNCTION(BlueprintCallable, Category = "Faction")
+	void SetControlledByPlayer(const bool bIsControlled);
+
+	/**Called every time the faction mask changes*/
+	UPROPERTY(BlueprintAssignable, Category = "Faction")
+	FOnRPGFactionChanged OnFactionChanged;
+
+protected:
+
+	/**Keep the "Enemy"/"Player" actor tags in sync with the mask*/
+	void MirrorFactionToActorTags() const;
+
+	/**Current allegiance bits*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Faction", meta = (Bitmask, BitmaskEnum = "ERPGFactionFlags"))
+	uint8 FactionMask;
+
+	/**Faction before being controlled*/
+	uint8 FactionMaskBeforeControl;
+
+	/**If it is true the "Enemy"/"Player" tags of the owner follow the mask*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Faction")
+	uint8 bMirrorToActorTags : 1;
+};
@@ -0,0 +1,72 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+/**
+ * Engine free formation layouts of the transcendence hammers.
+ * The evenly spaced slot angles of every hammer count are generated at compile time, so spawning and re-spacing
+ * the hammers is a table read without the truncation of integer division (360 / 7, 360 / 11...).
+ */
+namespace RPGHammerFormation
+{
+	/**Largest hammer count with a precomputed layout, bigger counts compute the same angles at runtime*/
+	constexpr int MaxTableHammers = 32;
+
+	/**Slot angles of every hammer count, SlotAngles[NumberOfHammers][SlotIndex] with SlotIndex up to NumberOfHammers (full turn)*/
+	struct FFormationTable
+	{
+		float SlotAngles[MaxTableHammers + 1][MaxTableHammers + 1];
+
+		constexpr FFormationTable()
+			: SlotAngles{}
+		{
+			for (int NumberOfHammers = 1; NumberOfHammers <= MaxTableHammers; NumberOfHammers++)
+			{
+				for (int SlotIndex = 0; SlotIndex <= NumberOfHammers; SlotIndex++)
+				{
+					SlotAngles[NumberOfHammers][SlotIndex] = static_cast<float>(SlotIndex) * 360.f / static_cast<float>(NumberOfHammers);
+				}
+			}
+		}
+	};
+
+	inline const FFormationTable& GetFormationTable()
+	{
+		static constexpr FFormationTable FormationTable;
+		return FormationTable;
+	}
+
+	/**Angle of the slot in an evenly spaced formation of NumberOfHammers*/
+	inline float SlotAngle(const int SlotIndex, const int NumberOfHammers)
+	{
+		if (NumberOfHammers <= 0)
+		{
+			return 0.f;
+		}
+
+		const bool bIsInTable = NumberOfHammers <= MaxTableHammers && SlotIndex >= 0 && SlotIndex <= NumberOfHammers;
+		return bIsInTable ? GetFormationTable().SlotAngles[NumberOfHammers][SlotIndex] : static_cast<float>(SlotIndex) * 360.f / static_cast<float>(NumberOfHammers);
+	}
+
+	/**Initial angle of a hammer when the ability spawns them*/
+	inline float InitialSlotAngle(const int HammerIndex, const int NumberOfHammers)
+	{
+		return SlotAngle(HammerIndex, NumberOfHammers);
+	}
+
+	/**
+	 * Angle the hammer at FormationRank has to move when the first NumUsedHammers of the formation are consumed together.
+	 * The first used hammer is rank 0, the remaining hammers are spaced from it in the smaller formation.
+	 */
+	inline float RelayoutSlotDelta(const int FormationRank, const int RemainingNumberOfHammers, const int NumUsedHammers = 1)
+	{
+		return SlotAngle(FormationRank, RemainingNumberOfHammers) - SlotAngle(FormationRank + NumUsedHammers - 1, RemainingNumberOfHammers + NumUsedHammers);
+	}
+
+	/**Angle added to a remaining hammer when hammers are consumed, hammers rotating to the right keep their angle in the negative turn*/
+	inline float RelayoutAngleOffset(const int FormationRank, const int RemainingNumberOfHammers, const float RotationDirection, const int NumUsedHammers = 1)
+	{
+		const float AnglesVariance = RotationDirection > 0.f ? 360.f : 0.f;
+		return RelayoutSlotDelta(FormationRank, RemainingNumberOfHammers, NumUsedHammers) - AnglesVariance;
+	}
+}
@@ -0,0 +1,228 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SergioTestContentClasses/RPGHammerOrbitKernel.h"
+#include "SergioTestContentClasses/RPGHammerOrbitMath.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Components/SceneComponent.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogRPGHammerOrbitKernel, Log, All);
+
+namespace RPGHammerOrbitKernel
+{
+	/**Number of hammers processed per vector register*/
+	static constexpr int32 LaneCount = 4;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void RPGHammerOrbitKernel::AdvanceOrbitAroundZ(const FRPGHammerOrbitBatch& Batch, const FVector& OrbitCenter, const float DeltaSeconds, FVector* OutPositions)
+{
+	const VectorRegister VecDeltaSeconds = VectorSetFloat1(DeltaSeconds);
+	const VectorRegister VecFullTurn = VectorSetFloat1(360.f);
+	const VectorRegister VecDegreesToRadians = VectorSetFloat1(PI / 180.f);
+
+	const int32 NumVectorized = Batch.Num - (Batch.Num % LaneCount);
+	for (int32 Index = 0; Index < NumVectorized; Index += LaneCount)
+	{
+		const VectorRegister VecSpeed = VectorLoad(Batch.RotationSpeed + Index);
+		const VectorRegister VecDirection = VectorLoad(Batch.RotationDirection + Index);
+		const VectorRegister VecRadius = VectorLoad(Batch.RotationRadius + Index);
+
+		//New angle = ((Speed * Delta) * Direction) + Angle, reset to 0 when it reaches a full turn
+		VectorRegister VecAngle = VectorLoad(Batch.RotationAngleAxis + Index);
+		VecAngle = VectorMultiplyAdd(VectorMultiply(VecSpeed, VecDeltaSeconds), VecDirection, VecAngle);
+		const VectorRegister VecFullTurnMask = VectorCompareGE(VectorAbs(VecAngle), VecFullTurn);
+		VecAngle = VectorSelect(VecFullTurnMask, VectorZero(), VecAngle);
+		VectorStore(VecAngle, Batch.RotationAngleAxis + Index);
+
+		//(Radius, 0, 0) rotated about Z is (Radius * Cos, Radius * Sin, 0)
+		VectorRegister VecSin;
+		VectorRegister VecCos;
+		const VectorRegister VecRadians = VectorMultiply(VecAngle, VecDegreesToRadians);
+		VectorSinCos(&VecSin, &VecCos, &VecRadians);
+
+		float OffsetX[LaneCount];
+		float OffsetY[LaneCount];
+		VectorStore(VectorMultiply(VecRadius, VecCos), OffsetX);
+		VectorStore(VectorMultiply(VecRadius, VecSin), OffsetY);
+
+		for (int32 Lane = 0; Lane < LaneCount; Lane++)
+		{
+			OutPositions[Index + Lane] = FVector(OrbitCenter.X + OffsetX[Lane], OrbitCenter.Y + OffsetY[Lane], OrbitCenter.Z);
+		}
+	}
+
+	for (int32 Index = NumVectorized; Index < Batch.Num; Index++)
+	{
+		const float NewAngleAxis = RPGHammerOrbitMath::AdvanceAngle(Batch.RotationAngleAxis[Index], Batch.RotationSpeed[Index], Batch.RotationDirection[Index], DeltaSeconds);
+		Batch.RotationAngleAxis[Index] = NewAngleAxis;
+
+		float Sin;
+		float Cos;
+		FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(NewAngleAxis));
+		OutPositions[Index] = FVector(OrbitCenter.X + Batch.RotationRadius[Index] * Cos, OrbitCenter.Y + Batch.RotationRadius[Index] * Sin, OrbitCenter.Z);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void RPGHammerOrbitKernel::AdvanceOrbitScalar(const FRPGHammerOrbitBatch& Batch, const FVector& OrbitCenter, const float DeltaSeconds, FVector* OutPositions)
+{
+	for (int32 Index = 0; Index < Batch.Num; Index++)
+	{
+		const float NewAngleAxis = RPGHammerOrbitMath::AdvanceAngle(Batch.RotationAngleAxis[Index], Batch.RotationSpeed[Index], Batch.RotationDirection[Index], DeltaSeconds);
+		Batch.RotationAngleAxis[Index] = NewAngleAxis;
+
+		const FVector RotateAxisVector = Batch.RotateAxisVector ? Batch.RotateAxisVector[Index] : FVector::UpVector;
+		const FVector VectorRadius = FVector(Batch.RotationRadius[Index], 0.f, 0.f);
+		OutPositions[Index] = OrbitCenter + VectorRadius.RotateAngleAxis(NewAngleAxis, RotateAxisVector);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+/**Actor with a movable scene root standing for a hammer or its owner in the benchmark*/
+static AActor* SpawnBenchmarkActor(UWorld* World, const FVector& Location)
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParameters.ObjectFlags |= RF_Transient;
+	AActor* BenchmarkActor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(Location), SpawnParameters);
+	if (!BenchmarkActor)
+	{
+		return nullptr;
+	}
+
+	USceneComponent* RootComponent = NewObject<USceneComponent>(BenchmarkActor, TEXT("BenchmarkRoot"));
+	RootComponent->SetMobility(EComponentMobility::Movable);
+	BenchmarkActor->SetRootComponent(RootComponent);
+	RootComponent->RegisterComponent();
+	BenchmarkActor->SetActorLocation(Location);
+	return BenchmarkActor;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Micro benchmark of the orbit update: RPG.Transcendence.BenchmarkOrbitKernel [NumHammers] [NumFrames]
+ * The per actor case moves spawned actors the way the original timer of every hammer did (owner reads, easing, angle,
+ * RotateAngleAxis and SetActorLocation) without the timer dispatch. The scalar and batched Z cases only run the orbit math
+ * over the structure of arrays, the display commit of the subsystem comes on top of them.
+ */
+static void BenchmarkOrbitKernel(const TArray<FString>& Args, UWorld* World)
+{
+	const int32 NumHammers = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1024;
+	const int32 NumFrames = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 1000;
+	const float DeltaSeconds = 1.f / 60.f;
+
+	TArray<float> Angles;
+	TArray<float> Speeds;
+	TArray<float> Directions;
+	TArray<float> Radii;
+	TArray<FVector> Positions;
+	Angles.SetNumUninitialized(NumHammers);
+	Speeds.SetNumUninitialized(NumHammers);
+	Directions.SetNumUninitialized(NumHammers);
+	Radii.SetNumUninitialized(NumHammers);
+	Positions.SetNumUninitialized(NumHammers);
+
+	FRandomStream RandomStream(NumHammers);
+	for (int32 Index = 0; Index < NumHammers; Index++)
+	{
+		Angles[Index] = RandomStream.FRandRange(-360.f, 360.f);
+		Speeds[Index] = RandomStream.FRandRange(180.f, 350.f);
+		Directions[Index] = RandomStream.FRand() > 0.5f ? 1.f : -1.f;
+		Radii[Index] = RandomStream.FRandRange(70.f, 200.f);
+	}
+
+	const FVector OrbitCenter(100.f, 200.f, 90.f);
+
+	//Baseline: every hammer actor reads its owner and moves itself
+	double PerActorSeconds = 0.0;
+	if (World)
+	{
+		AActor* OwnerActor = SpawnBenchmarkActor(World, OrbitCenter);
+		TArray<AActor*> HammerActors;
+		TArray<RPGHammerOrbitMath::TOrbitState<float, FVector>> HammerStates;
+		HammerActors.Reserve(NumHammers);
+		HammerStates.SetNum(NumHammers);
+		for (int32 Index = 0; Index < NumHammers && OwnerActor; Index++)
+		{
+			HammerStates[Index].RotationAngleAxis = Angles[Index];
+			HammerStates[Index].RotationSpeed = Speeds[Index];
+			HammerStates[Index].RotationDirection = Directions[Index];
+			HammerStates[Index].RotationRadius = Radii[Index];
+			if (AActor* HammerActor = SpawnBenchmarkActor(World, OrbitCenter))
+			{
+				HammerActors.Add(HammerActor);
+			}
+		}
+
+		const RPGHammerOrbitMath::TOrbitProfile<float> OrbitProfile;
+		const double PerActorStartTime = FPlatformTime::Seconds();
+		for (int32 Frame = 0; Frame < NumFrames; Frame++)
+		{
+			for (int32 Index = 0; Index < HammerActors.Num(); Index++)
+			{
+				RPGHammerOrbitMath::TOrbitState<float, FVector>& HammerState = HammerStates[Index];
+				RPGHammerOrbitMath::EaseOrbit(HammerState, OrbitProfile, OwnerActor->GetActorForwardVector(), OwnerActor->GetActorRightVector());
+				HammerState.RotationAngleAxis = RPGHammerOrbitMath::AdvanceAngle(HammerState.RotationAngleAxis, HammerState.RotationSpeed, HammerState.RotationDirection, DeltaSeconds);
+				const FVector RotateNewLocation = FVector(HammerState.RotationRadius, 0.f, 0.f).RotateAngleAxis(HammerState.RotationAngleAxis, FVector::UpVector);
+				HammerActors[Index]->SetActorLocation(OwnerActor->GetActorLocation() + RotateNewLocation);
+			}
+		}
+		PerActorSeconds = FPlatformTime::Seconds() - PerActorStartTime;
+
+		for (AActor* HammerActor : HammerActors)
+		{
+			HammerActor->Destroy();
+		}
+		if (OwnerActor)
+		{
+			OwnerActor->Destroy();
+		}
+	}
+
+	FRPGHammerOrbitBatch Batch;
+	Batch.RotationAngleAxis = Angles.GetData();
+	Batch.RotationSpeed = Speeds.GetData();
+	Batch.RotationDirection = Directions.GetData();
+	Batch.RotationRadius = Radii.GetData();
+	Batch.Num = NumHammers;
+
+	const double ScalarStartTime = FPlatformTime::Seconds();
+	for (int32 Frame = 0; Frame < NumFrames; Frame++)
+	{
+		RPGHammerOrbitKernel::AdvanceOrbitScalar(Batch, OrbitCenter, DeltaSeconds, Positions.GetData());
+	}
+	const double ScalarSeconds = FPlatformTime::Seconds() - ScalarStartTime;
+
+	const double BatchedStartTime = FPlatformTime::Seconds();
+	for (int32 Frame = 0; Frame < NumFrames; Frame++)
+	{
+		RPGHammerOrbitKernel::AdvanceOrbitAroundZ(Batch, OrbitCenter, DeltaSeconds, Positions.GetData());
+	}
+	const double BatchedSeconds = FPlatformTime::Seconds() - BatchedStartTime;
+
+	const double NanosecondsScale = 1.0e9 / (static_cast<double>(NumHammers) * NumFrames);
+	UE_LOG(LogRPGHammerOrbitKernel, Display, TEXT("Orbit kernel %d hammers x %d frames: scalar math %.2f ns/hammer, batched Z math %.2f ns/hammer (x%.2f)"),
+		NumHammers, NumFrames, ScalarSeconds * NanosecondsScale, BatchedSeconds * NanosecondsScale, BatchedSeconds > 0.0 ? ScalarSeconds / BatchedSeconds : 0.0);
+
+	if (World)
+	{
+		UE_LOG(LogRPGHammerOrbitKernel, Display, TEXT("Orbit kernel %d hammers x %d frames: per actor update %.2f ns/hammer (x%.2f against the batched Z math, the subsystem commit is not included)"),
+			NumHammers, NumFrames, PerActorSeconds * NanosecondsScale, BatchedSeconds > 0.0 ? PerActorSeconds / BatchedSeconds : 0.0);
+	}
+	else
+	{
+		UE_LOG(LogRPGHammerOrbitKernel, Warning, TEXT("Orbit kernel: no world to spawn the per actor baseline, only the orbit math was measured"));
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkOrbitKernelCommand(
+	TEXT("RPG.Transcendence.BenchmarkOrbitKernel"),
+	TEXT("Compares the per actor orbit update of the hammers against the scalar and the batched orbit kernels. Usage: RPG.Transcendence.BenchmarkOrbitKernel [NumHammers] [NumFrames]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkOrbitKernel));
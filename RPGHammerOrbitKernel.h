@@ -0,0 +1,36 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**Structure of arrays view of the hammers orbiting the same player*/
+struct FRPGHammerOrbitBatch
+{
+	/**Angle which each hammer rotates based on the player, advanced in place*/
+	float* RotationAngleAxis = nullptr;
+
+	/**The speed at which each hammer rotates*/
+	const float* RotationSpeed = nullptr;
+
+	/**Direction in which each hammer rotates, -1 left or 1 right*/
+	const float* RotationDirection = nullptr;
+
+	/**The radius at which each hammer rotates*/
+	const float* RotationRadius = nullptr;
+
+	/**Axis of each hammer, only read by the generic path*/
+	const FVector* RotateAxisVector = nullptr;
+
+	int32 Num = 0;
+};
+
+/**Batched orbit position kernels, all of them advance the angles and write the new world positions of the whole batch in one pass*/
+namespace RPGHammerOrbitKernel
+{
+	/**Vectorized path for the common case where every hammer rotates about Z, the rotation reduces to sin/cos in the plane*/
+	ACTIONRPG_API void AdvanceOrbitAroundZ(const FRPGHammerOrbitBatch& Batch, const FVector& OrbitCenter, const float DeltaSeconds, FVector* OutPositions);
+
+	/**Scalar path with one RotateAngleAxis per hammer, same math as the original per actor update*/
+	ACTIONRPG_API void AdvanceOrbitScalar(const FRPGHammerOrbitBatch& Batch, const FVector& OrbitCenter, const float DeltaSeconds, FVector* OutPositions);
+}
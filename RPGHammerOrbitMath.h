@@ -0,0 +1,249 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include <cmath>
+
+/**
+ * Engine free math of the transcendence hammers: orbit easing, angle advance, spinning limits,
+ * fire window and the approach to the controlled enemy. The formation angles live in RPGHammerFormation.h.
+ * Everything is templated on the scalar and vector types so the same code runs on FVector/float inside
+ * the game and on plain structs outside the editor. Vector types only need X, Y, Z members and a (X, Y, Z) constructor.
+ * State types only need the members of TOrbitState and profile types the members of TOrbitProfile.
+ */
+namespace RPGHammerOrbitMath
+{
+	/**Tuning constants of the original orbit behaviour*/
+	template<typename ScalarType>
+	struct TOrbitTuning
+	{
+		/**Speed gained per update while the orbit expands*/
+		static constexpr ScalarType ExpandSpeedStep = ScalarType(3);
+
+		/**Speed lost per update while the orbit contracts*/
+		static constexpr ScalarType ContractSpeedStep = ScalarType(1);
+
+		/**Radius gained or lost per update*/
+		static constexpr ScalarType RadiusStep = ScalarType(1);
+
+		/**Dot product tolerance to consider the player did not turn*/
+		static constexpr ScalarType ValidVarianceTolerance = ScalarType(0.016);
+
+		/**Absolute angle where a spinning hammer is fired, and its tolerance*/
+		static constexpr ScalarType FireAngle = ScalarType(120);
+		static constexpr ScalarType FireAngleTolerance = ScalarType(5);
+
+		/**Minimum speed multiplier and minimum radius divisor while spinning*/
+		static constexpr ScalarType SpinningSpeedScale = ScalarType(6);
+		static constexpr ScalarType SpinningRadiusScale = ScalarType(2);
+
+		static constexpr ScalarType FullTurn = ScalarType(360);
+	};
+
+	/**Plain read-only orbit limits with the member names expected by the state functions*/
+	template<typename ScalarType>
+	struct TOrbitProfile
+	{
+		ScalarType MinRotationSpeedValue = ScalarType(180);
+		ScalarType MaxRotationSpeedValue = ScalarType(350);
+		ScalarType MinRotationRadiusValue = ScalarType(70);
+		ScalarType MaxRotationRadiusValue = ScalarType(200);
+	};
+
+	/**Plain orbit state with the member names expected by the state functions, only the dynamic values*/
+	template<typename ScalarType, typename VectorType>
+	struct TOrbitState
+	{
+		ScalarType RotationAngleAxis = ScalarType(0);
+		ScalarType RotationDirection = ScalarType(-1);
+		ScalarType RotationSpeed = ScalarType(180);
+		ScalarType RotationRadius = ScalarType(70);
+		VectorType PreviewForwardVectorToCompare = VectorType(ScalarType(0), ScalarType(0), ScalarType(0));
+		ScalarType CurrentDotAngleVariance = ScalarType(0);
+		bool bIsInSpinningMode = false;
+	};
+
+	template<typename ScalarType>
+	inline ScalarType Clamp(const ScalarType Value, const ScalarType Min, const ScalarType Max)
+	{
+		return Value < Min ? Min : (Value < Max ? Value : Max);
+	}
+
+	template<typename ScalarType>
+	inline bool IsNearlyEqual(const ScalarType A, const ScalarType B, const ScalarType Tolerance)
+	{
+		return std::abs(A - B) <= Tolerance;
+	}
+
+	template<typename VectorType>
+	inline auto Dot(const VectorType& A, const VectorType& B) -> decltype(A.X * B.X)
+	{
+		return A.X * B.X + A.Y * B.Y + A.Z * B.Z;
+	}
+
+	template<typename ScalarType>
+	inline ScalarType DegreesToRadians(const ScalarType Degrees)
+	{
+		return Degrees * ScalarType(3.14159265358979323846 / 180.0);
+	}
+
+	/**New angle after one update, reset to 0 when it reaches a full turn*/
+	template<typename ScalarType>
+	inline ScalarType AdvanceAngle(const ScalarType AngleAxis, const ScalarType Speed, const ScalarType Direction, const ScalarType DeltaSeconds)
+	{
+		const ScalarType NewAngleAxis = ((Speed * DeltaSeconds) * Direction) + AngleAxis;
+		const bool bHasToResetAngleAxis = NewAngleAxis >= TOrbitTuning<ScalarType>::FullTurn || NewAngleAxis <= -TOrbitTuning<ScalarType>::FullTurn;
+		return bHasToResetAngleAxis ? ScalarType(0) : NewAngleAxis;
+	}
+
+	/**Angle after Seconds at constant speed, wrapped at a full turn.
+	 * AdvanceAngle snaps to 0 and drops the overshoot of the step that completes a turn, this keeps it, so after every full turn
+	 * the result leads the stepped angle by up to one step of angle. Checks made on this angle widen the fire window by that step*/
+	template<typename ScalarType>
+	inline ScalarType AdvanceAngleAnalytic(const ScalarType AngleAxis, const ScalarType Speed, const ScalarType Direction, const ScalarType Seconds)
+	{
+		const ScalarType FullTurn = TOrbitTuning<ScalarType>::FullTurn;
+
+		//Measured along the rotation direction the angle only grows
+		const ScalarType Sign = Direction < ScalarType(0) ? ScalarType(-1) : ScalarType(1);
+		const ScalarType ForwardAngle = AngleAxis * Sign + std::abs(Speed) * Seconds;
+		const ScalarType NewForwardAngle = ForwardAngle < FullTurn ? ForwardAngle : std::fmod(ForwardAngle - FullTurn, FullTurn);
+		return NewForwardAngle * Sign;
+	}
+
+	/**(Radius, 0, 0) rotated about Z*/
+	template<typename VectorType, typename ScalarType>
+	inline VectorType OrbitOffsetAboutZ(const ScalarType Radius, const ScalarType AngleDegrees)
+	{
+		const ScalarType Radians = DegreesToRadians(AngleDegrees);
+		return VectorType(Radius * std::cos(Radians), Radius * std::sin(Radians), ScalarType(0));
+	}
+
+	/**(Radius, 0, 0) rotated about any normalized axis*/
+	template<typename VectorType, typename ScalarType>
+	inline VectorType OrbitOffsetAboutAxis(const ScalarType Radius, const ScalarType AngleDegrees, const VectorType& Axis)
+	{
+		const ScalarType Radians = DegreesToRadians(AngleDegrees);
+		const ScalarType S = std::sin(Radians);
+		const ScalarType C = std::cos(Radians);
+		const ScalarType OMC = ScalarType(1) - C;
+		return VectorType(
+			(OMC * Axis.X * Axis.X + C) * Radius,
+			(OMC * Axis.X * Axis.Y + Axis.Z * S) * Radius,
+			(OMC * Axis.Z * Axis.X - Axis.Y * S) * Radius);
+	}
+
+	/**The player is in a sufficiently accurate and valid rotation to keep the direction, stores the dot variance in the state*/
+	template<typename StateType, typename VectorType>
+	inline bool GetRotationValidVariance(StateType& State, const VectorType& OwnerRightVector)
+	{
+		using ScalarType = decltype(State.CurrentDotAngleVariance);
+		State.CurrentDotAngleVariance = Dot(State.PreviewForwardVectorToCompare, OwnerRightVector);
+		return IsNearlyEqual(State.CurrentDotAngleVariance, ScalarType(0), TOrbitTuning<ScalarType>::ValidVarianceTolerance);
+	}
+
+	/**Hammers expanding on their own orbit, the direction follows the side the player turned to. NumSteps simulation steps are applied at once*/
+	template<typename StateType, typename ProfileType>
+	inline void ExpandedRotation(StateType& State, const ProfileType& Profile, const int NumSteps = 1)
+	{
+		using ScalarType = decltype(State.RotationSpeed);
+		const ScalarType StepScale = static_cast<ScalarType>(NumSteps);
+		State.RotationSpeed = Clamp(State.RotationSpeed + TOrbitTuning<ScalarType>::ExpandSpeedStep * StepScale, Profile.MinRotationSpeedValue, Profile.MaxRotationSpeedValue);
+		State.RotationRadius = Clamp(State.RotationRadius + TOrbitTuning<ScalarType>::RadiusStep * StepScale, Profile.MinRotationRadiusValue, Profile.MaxRotationRadiusValue);
+		State.RotationDirection = State.CurrentDotAngleVariance > ScalarType(0) ? ScalarType(-1) : ScalarType(1);
+	}
+
+	/**Hammers contracted on their own orbit. NumSteps simulation steps are applied at once*/
+	template<typename StateType, typename ProfileType>
+	inline void ContractedRotation(StateType& State, const ProfileType& Profile, const int NumSteps = 1)
+	{
+		using ScalarType = decltype(State.RotationSpeed);
+		const ScalarType StepScale = static_cast<ScalarType>(NumSteps);
+		State.RotationSpeed = Clamp(State.RotationSpeed - TOrbitTuning<ScalarType>::ContractSpeedStep * StepScale, Profile.MinRotationSpeedValue, Profile.MaxRotationSpeedValue);
+		State.RotationRadius = Clamp(State.RotationRadius - TOrbitTuning<ScalarType>::RadiusStep * StepScale, Profile.MinRotationRadiusValue, Profile.MaxRotationRadiusValue);
+	}
+
+	/**Expand or contract the orbit within the limits of the profile and remember the player forward for the next update.
+	 * A reduced rate update covering several simulation steps eases by all of them, the limits make it match easing step by step*/
+	template<typename StateType, typename ProfileType, typename VectorType>
+	inline void EaseOrbit(StateType& State, const ProfileType& Profile, const VectorType& OwnerForwardVector, const VectorType& OwnerRightVector, const int NumSteps = 1)
+	{
+		if (GetRotationValidVariance(State, OwnerRightVector) || State.bIsInSpinningMode)
+		{
+			ContractedRotation(State, Profile, NumSteps);
+		}
+		else
+		{
+			ExpandedRotation(State, Profile, NumSteps);
+		}
+		State.PreviewForwardVectorToCompare = OwnerForwardVector;
+	}
+
+	/**Faster and tighter limits of the spinning mode derived from the normal orbit ones*/
+	template<typename ProfileType>
+	inline ProfileType MakeSpinningProfile(const ProfileType& OrbitProfile)
+	{
+		using ScalarType = decltype(OrbitProfile.MinRotationSpeedValue);
+		ProfileType SpinningProfile = OrbitProfile;
+		SpinningProfile.MinRotationSpeedValue = OrbitProfile.MinRotationSpeedValue * TOrbitTuning<ScalarType>::SpinningSpeedScale;
+		SpinningProfile.MinRotationRadiusValue = OrbitProfile.MinRotationRadiusValue / TOrbitTuning<ScalarType>::SpinningRadiusScale;
+		return SpinningProfile;
+	}
+
+	/**The hammer is in the front zone where it can be fired smoothly, ExtraTolerance widens the zone on both sides*/
+	template<typename ScalarType>
+	inline bool IsInFireWindow(const ScalarType AngleAxis, const ScalarType ExtraTolerance = ScalarType(0))
+	{
+		return IsNearlyEqual(std::abs(AngleAxis), TOrbitTuning<ScalarType>::FireAngle, TOrbitTuning<ScalarType>::FireAngleTolerance + ExtraTolerance);
+	}
+
+	/**Seconds at constant speed until the angle enters the fire window, 0 if it already is inside, negative if it never does*/
+	template<typename ScalarType>
+	inline ScalarType SecondsToFireWindow(const ScalarType AngleAxis, const ScalarType Speed, const ScalarType Direction)
+	{
+		const ScalarType WindowStart = TOrbitTuning<ScalarType>::FireAngle - TOrbitTuning<ScalarType>::FireAngleTolerance;
+		const ScalarType WindowEnd = TOrbitTuning<ScalarType>::FireAngle + TOrbitTuning<ScalarType>::FireAngleTolerance;
+		if (IsInFireWindow(AngleAxis))
+		{
+			return ScalarType(0);
+		}
+
+		const ScalarType AbsSpeed = std::abs(Speed);
+		if (AbsSpeed <= ScalarType(0))
+		{
+			return ScalarType(-1);
+		}
+
+		//Measured along the rotation direction the next window is either ahead on this side, or after the reset to 0
+		const ScalarType ForwardAngle = AngleAxis * (Direction < ScalarType(0) ? ScalarType(-1) : ScalarType(1));
+		if (ForwardAngle < -WindowEnd)
+		{
+			return (-WindowEnd - ForwardAngle) / AbsSpeed;
+		}
+		if (ForwardAngle < WindowStart)
+		{
+			return (WindowStart - ForwardAngle) / AbsSpeed;
+		}
+		return ((TOrbitTuning<ScalarType>::FullTurn - ForwardAngle) + WindowStart) / AbsSpeed;
+	}
+
+	/**Lerp alpha of the hammer moving to the enemy after ElapsedSeconds*/
+	template<typename ScalarType>
+	inline ScalarType MoveToEnemyAlpha(const ScalarType ElapsedSeconds, const ScalarType SmoothValueRange)
+	{
+		return SmoothValueRange > ScalarType(0) ? Clamp(ElapsedSeconds / SmoothValueRange, ScalarType(0), ScalarType(1)) : ScalarType(1);
+	}
+
+	/**The hammer is close enough to the enemy to attach to it*/
+	template<typename ScalarType>
+	inline bool IsMoveToEnemyCloseEnough(const ScalarType LerpAlpha, const ScalarType SmoothValueRange)
+	{
+		return LerpAlpha >= (ScalarType(0.3) / SmoothValueRange);
+	}
+
+	template<typename VectorType, typename ScalarType>
+	inline VectorType Lerp(const VectorType& A, const VectorType& B, const ScalarType Alpha)
+	{
+		return VectorType(A.X + (B.X - A.X) * Alpha, A.Y + (B.Y - A.Y) * Alpha, A.Z + (B.Z - A.Z) * Alpha);
+	}
+}
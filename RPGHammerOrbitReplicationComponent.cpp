@@ -0,0 +1,272 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SergioTestContentClasses/RPGHammerOrbitReplicationComponent.h"
+#include "SergioTestContentClasses/RPGTranscendenceHammer.h"
+#include "SergioTestContentClasses/RPGTranscendenceHammerPool.h"
+#include "SergioTestContentClasses/RPGTranscendenceHammerSubsystem.h"
+#include "SergioTestContentClasses/RPGTranscendesAbility.h"
+#include "SergioTestContentClasses/RPGHammerFormation.h"
+#include "RPGCharacterBase.h"
+#include "Net/UnrealNetwork.h"
+
+URPGHammerOrbitReplicationComponent::URPGHammerOrbitReplicationComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	SetIsReplicatedByDefault(true);
+
+	SimulatedActivationId = 0;
+	NumReservedPoolHammers = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+URPGHammerOrbitReplicationComponent* URPGHammerOrbitReplicationComponent::FindOrAddOrbitReplicationComponent(ARPGCharacterBase* OwnerCharacter)
+{
+	if (!IsValid(OwnerCharacter))
+	{
+		return nullptr;
+	}
+
+	URPGHammerOrbitReplicationComponent* OrbitReplication = OwnerCharacter->FindComponentByClass<URPGHammerOrbitReplicationComponent>();
+	if (OrbitReplication || !OwnerCharacter->HasAuthority())
+	{
+		return OrbitReplication;
+	}
+
+	//Replicated as a dynamic sub object of the player, the clients create their copy from the server one
+	OrbitReplication = NewObject<URPGHammerOrbitReplicationComponent>(OwnerCharacter);
+	OrbitReplication->RegisterComponent();
+
+	return OrbitReplication;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGHammerOrbitReplicationComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(URPGHammerOrbitReplicationComponent, OrbitDescriptor);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGHammerOrbitReplicationComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ReleaseSimulatedHammers();
+	ReleasePoolCapacity();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGHammerOrbitReplicationComponent::BeginReplicatedOrbit(TSubclassOf<ARPGTranscendenceHammer> HammerClass, const int32 NumberOfHammers, const bool bOwnerRunsAbility)
+{
+	OrbitDescriptor.HammerClass = HammerClass;
+	OrbitDescriptor.ActivationId++;
+	ensureMsgf(NumberOfHammers <= MaxReplicatedHammers, TEXT("A replicated orbit describes at most %d hammers, %d requested"), MaxReplicatedHammers, NumberOfHammers);
+	OrbitDescriptor.NumberOfHammers = static_cast<uint8>(FMath::Clamp(NumberOfHammers, 0, MaxReplicatedHammers));
+	OrbitDescriptor.bOwnerRunsAbility = bOwnerRunsAbility;
+	OrbitDescriptor.UsedHammersMask = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGHammerOrbitReplicationComponent::EndReplicatedOrbit()
+{
+	OrbitDescriptor.NumberOfHammers = 0;
+	OrbitDescriptor.UsedHammersMask = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGHammerOrbitReplicationComponent::NotifyHammersUsed(const TArray<FRPGHammerUse>& HammerUses, const bool bHasToControl)
+{
+	for (const FRPGHammerUse& HammerUse : HammerUses)
+	{
+		if (HammerUse.HammerIndex < OrbitDescriptor.NumberOfHammers)
+		{
+			OrbitDescriptor.UsedHammersMask |= 1u << HammerUse.HammerIndex;
+		}
+	}
+
+	MulticastHammersUsed(HammerUses, bHasToControl);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGHammerOrbitReplicationComponent::NotifyHammerFired(const int32 HammerIndex)
+{
+	if (HammerIndex < 0 || HammerIndex >= OrbitDescriptor.NumberOfHammers)
+	{
+		return;
+	}
+
+	MulticastHammerFired(static_cast<uint8>(HammerIndex));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGHammerOrbitReplicationComponent::OnRep_OrbitDescriptor()
+{
+	const bool bIsNewActivation = OrbitDescriptor.ActivationId != SimulatedActivationId;
+	if (bIsNewActivation || OrbitDescriptor.NumberOfHammers == 0 || !ShouldSimulateHammers())
+	{
+		ReleaseSimulatedHammers();
+	}
+
+	if (SimulatedHammers.Num() > 0 || OrbitDescriptor.NumberOfHammers == 0 || !ShouldSimulateHammers())
+	{
+		return;
+	}
+
+	SpawnSimulatedHammers();
+
+	//Late joining clients skip the hammers that were already used before they received the orbit
+	for (int32 HammerIndex = 0; HammerIndex < SimulatedHammers.Num(); HammerIndex++)
+	{
+		const bool bWasUsed = (OrbitDescriptor.UsedHammersMask & (1u << HammerIndex)) != 0;
+		if (bWasUsed)
+		{
+			SimulatedFormationHammerIndices.RemoveSingle(HammerIndex);
+			if (IsValid(SimulatedHammers[HammerIndex]))
+			{
+				SimulatedHammers[HammerIndex]->MarkUsedByServer();
+			}
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGHammerOrbitReplicationComponent::MulticastHammersUsed_Implementation(const TArray<FRPGHammerUse>& HammerUses, const bool bHasToControl)
+{
+	if (!ShouldSimulateHammers() || SimulatedHammers.Num() == 0)
+	{
+		return;
+	}
+
+	//Same re-layout the server ability applies to its own hammers
+	URPGTranscendesAbility::ApplyHammerUses(Cast<ARPGCharacterBase>(GetOwner()), SimulatedHammers, SimulatedFormationHammerIndices, HammerUses, bHasToControl);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGHammerOrbitReplicationComponent::MulticastHammerFired_Implementation(const uint8 HammerIndex)
+{
+	if (!ShouldSimulateHammers() || !SimulatedHammers.IsValidIndex(HammerIndex))
+	{
+		return;
+	}
+
+	ARPGTranscendenceHammer* FiredHammer = SimulatedHammers[HammerIndex];
+	if (IsValid(FiredHammer))
+	{
+		FiredHammer->MarkUsedByServer();
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGHammerOrbitReplicationComponent::ShouldSimulateHammers() const
+{
+	const AActor* OwnerActor = GetOwner();
+	if (!IsValid(OwnerActor) || OwnerActor->HasAuthority())
+	{
+		return false;
+	}
+
+	//The predicting owner already drives its own hammers from the local ability
+	return OwnerActor->GetLocalRole() == ROLE_SimulatedProxy || !OrbitDescriptor.bOwnerRunsAbility;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGHammerOrbitReplicationComponent::SpawnSimulatedHammers()
+{
+	ARPGCharacterBase* OwnerCharacter = Cast<ARPGCharacterBase>(GetOwner());
+	URPGTranscendenceHammerPool* HammerPool = GetWorld()->GetSubsystem<URPGTranscendenceHammerPool>();
+	if (!IsValid(OwnerCharacter) || !IsValid(HammerPool) || !IsValid(OrbitDescriptor.HammerClass))
+	{
+		return;
+	}
+
+	const int32 NumberOfHammers = OrbitDescriptor.NumberOfHammers;
+
+	//Without own capacity the client pool would destroy the hammers on release and spawn them again on the next activation
+	if (ReservedPoolHammerClass != OrbitDescriptor.HammerClass)
+	{
+		ReleasePoolCapacity();
+		ReservedPoolHammerClass = OrbitDescriptor.HammerClass;
+	}
+	if (NumberOfHammers > NumReservedPoolHammers)
+	{
+		HammerPool->PrewarmHammers(ReservedPoolHammerClass, NumberOfHammers - NumReservedPoolHammers);
+		NumReservedPoolHammers = NumberOfHammers;
+	}
+
+	URPGTranscendenceHammerSubsystem* OrbitSubsystem = GetWorld()->GetSubsystem<URPGTranscendenceHammerSubsystem>();
+	if (IsValid(OrbitSubsystem))
+	{
+		OrbitSubsystem->RegisterOrbitOwner(OwnerCharacter, NumberOfHammers);
+	}
+
+	//Same initial layout as the server, from there the orbit only depends on the owner movement
+	for (int32 HammerIndex = 0; HammerIndex < NumberOfHammers; HammerIndex++)
+	{
+		ARPGTranscendenceHammer* SimulatedHammer = HammerPool->AcquireHammer(OrbitDescriptor.HammerClass, OwnerCharacter, HammerIndex, RPGHammerFormation::InitialSlotAngle(HammerIndex, NumberOfHammers));
+		if (IsValid(SimulatedHammer))
+		{
+			SimulatedHammer->SetIsClientSimulated(true);
+		}
+
+		//Keep the slot even if it failed so the array index stays the hammer index of the server
+		SimulatedHammers.Add(SimulatedHammer);
+		SimulatedFormationHammerIndices.Add(HammerIndex);
+	}
+
+	SimulatedActivationId = OrbitDescriptor.ActivationId;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGHammerOrbitReplicationComponent::ReleaseSimulatedHammers()
+{
+	if (SimulatedHammers.Num() == 0)
+	{
+		return;
+	}
+
+	URPGTranscendenceHammerPool* HammerPool = GetWorld()->GetSubsystem<URPGTranscendenceHammerPool>();
+	for (ARPGTranscendenceHammer* SimulatedHammer : SimulatedHammers)
+	{
+		if (IsValid(SimulatedHammer) && IsValid(HammerPool))
+		{
+			HammerPool->ReleaseHammer(SimulatedHammer);
+		}
+	}
+	SimulatedHammers.Empty();
+	SimulatedFormationHammerIndices.Empty();
+
+	URPGTranscendenceHammerSubsystem* OrbitSubsystem = GetWorld()->GetSubsystem<URPGTranscendenceHammerSubsystem>();
+	if (IsValid(OrbitSubsystem))
+	{
+		OrbitSubsystem->UnregisterOrbitOwner(Cast<ARPGCharacterBase>(GetOwner()));
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGHammerOrbitReplicationComponent::ReleasePoolCapacity()
+{
+	URPGTranscendenceHammerPool* HammerPool = GetWorld()->GetSubsystem<URPGTranscendenceHammerPool>();
+	if (IsValid(HammerPool) && NumReservedPoolHammers > 0)
+	{
+		HammerPool->ReleasePrewarmedHammers(ReservedPoolHammerClass, NumReservedPoolHammers);
+	}
+
+	ReservedPoolHammerClass = nullptr;
+	NumReservedPoolHammers = 0;
+}
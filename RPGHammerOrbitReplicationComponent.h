@@ -0,0 +1,139 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "RPGHammerOrbitReplicationComponent.generated.h"
+
+class ARPGCharacterBase;
+class ARPGTranscendenceHammer;
+
+/**How the transcendence hammers of a player reach the clients*/
+UENUM(BlueprintType)
+enum class ERPGHammerNetMode : uint8
+{
+	/**Every hammer actor is replicated with its own movement*/
+	ReplicatedActors,
+	/**Only the orbit descriptor and the use events are replicated, every client simulates its own hammers*/
+	ClientSimulated
+};
+
+/**Everything a client needs to rebuild the orbit of an activation, the orbit itself is deterministic from the owner transform*/
+USTRUCT()
+struct FRPGHammerOrbitDescriptor
+{
+	GENERATED_BODY()
+
+	/**Hammer class spawned by the activation*/
+	UPROPERTY()
+	TSubclassOf<ARPGTranscendenceHammer> HammerClass;
+
+	/**Increased on every activation so the clients rebuild their hammers*/
+	UPROPERTY()
+	uint8 ActivationId = 0;
+
+	/**Number of hammers spawned by the activation, 0 while the ability is not active*/
+	UPROPERTY()
+	uint8 NumberOfHammers = 0;
+
+	/**The owning client runs the ability itself (predicted) and already has its own hammers*/
+	UPROPERTY()
+	bool bOwnerRunsAbility = false;
+
+	/**One bit per hammer index already used, lets the late joining clients skip them*/
+	UPROPERTY()
+	uint32 UsedHammersMask = 0;
+};
+
+/**A hammer committed by a use and the enemy it goes to control, nullptr for projectiles*/
+USTRUCT()
+struct FRPGHammerUse
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint8 HammerIndex = 0;
+
+	UPROPERTY()
+	ARPGCharacterBase* EnemyRef = nullptr;
+};
+
+/**
+ * Replicates the hammer orbit of a player as a compact descriptor plus discrete use/fire events
+ * instead of one replicated actor per hammer. Added to the player by the server when the ability runs in ClientSimulated mode.
+ */
+UCLASS(ClassGroup = (RPG))
+class ACTIONRPG_API URPGHammerOrbitReplicationComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	URPGHammerOrbitReplicationComponent();
+
+	/**Hammers a replicated orbit can describe, one bit of UsedHammersMask each. The ability caps ClientSimulated activations to it*/
+	static constexpr int32 MaxReplicatedHammers = 32;
+
+	/**Orbit replication component of the player, created on the server when the player does not have one*/
+	static URPGHammerOrbitReplicationComponent* FindOrAddOrbitReplicationComponent(ARPGCharacterBase* OwnerCharacter);
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/**Server: start replicating the orbit of a new activation*/
+	void BeginReplicatedOrbit(TSubclassOf<ARPGTranscendenceHammer> HammerClass, const int32 NumberOfHammers, const bool bOwnerRunsAbility);
+
+	/**Server: the activation finished, the clients release their hammers*/
+	void EndReplicatedOrbit();
+
+	/**Server: the hammers start spinning to be used, the rest of hammers re-layout once on every client*/
+	void NotifyHammersUsed(const TArray<FRPGHammerUse>& HammerUses, const bool bHasToControl);
+
+	/**Server: the hammer was fired as projectile, the clients hide it even if their orbit did not reach the fire window yet*/
+	void NotifyHammerFired(const int32 HammerIndex);
+
+protected:
+
+	UFUNCTION()
+	void OnRep_OrbitDescriptor();
+
+	UFUNCTION(NetMulticast, Reliable)
+	void MulticastHammersUsed(const TArray<FRPGHammerUse>& HammerUses, const bool bHasToControl);
+
+	UFUNCTION(NetMulticast, Reliable)
+	void MulticastHammerFired(const uint8 HammerIndex);
+
+	/**Does this machine have to simulate the hammers of the descriptor*/
+	bool ShouldSimulateHammers() const;
+
+	/**Acquire the local hammers of the current activation*/
+	void SpawnSimulatedHammers();
+
+	/**Return the local hammers to the pool*/
+	void ReleaseSimulatedHammers();
+
+	/**Give back the pool capacity reserved for the local hammers, their free hammers are destroyed*/
+	void ReleasePoolCapacity();
+
+	/**Current orbit of the owner, the only state replicated for the hammers*/
+	UPROPERTY(ReplicatedUsing = OnRep_OrbitDescriptor)
+	FRPGHammerOrbitDescriptor OrbitDescriptor;
+
+	/**Local non replicated hammers, the array index is the hammer index*/
+	UPROPERTY()
+	TArray<ARPGTranscendenceHammer*> SimulatedHammers;
+
+	/**Activation the local hammers were spawned for*/
+	uint8 SimulatedActivationId;
+
+	/**Indices of the local hammers not used yet in formation order*/
+	TArray<int32> SimulatedFormationHammerIndices;
+
+	/**Pool capacity reserved for the local hammers so they stay pooled between activations instead of being destroyed on release*/
+	UPROPERTY()
+	TSubclassOf<ARPGTranscendenceHammer> ReservedPoolHammerClass;
+
+	int32 NumReservedPoolHammers;
+};
@@ -0,0 +1,115 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SergioTestContentClasses/RPGHammerOrbitRigComponent.h"
+#include "SergioTestContentClasses/RPGTranscendenceHammer.h"
+#include "RPGCharacterBase.h"
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+URPGHammerOrbitRigComponent::URPGHammerOrbitRigComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	//The orbit is about a world axis, only the location follows the player. The scale is the formation radius
+	SetUsingAbsoluteRotation(true);
+	SetUsingAbsoluteScale(true);
+
+	RigOffsetTolerance = 0.05f;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+URPGHammerOrbitRigComponent* URPGHammerOrbitRigComponent::FindOrAddOrbitRig(ARPGCharacterBase* OwnerCharacter)
+{
+	if (!IsValid(OwnerCharacter) || !OwnerCharacter->GetRootComponent())
+	{
+		return nullptr;
+	}
+
+	URPGHammerOrbitRigComponent* OrbitRig = OwnerCharacter->FindComponentByClass<URPGHammerOrbitRigComponent>();
+	if (OrbitRig)
+	{
+		return OrbitRig;
+	}
+
+	OrbitRig = NewObject<URPGHammerOrbitRigComponent>(OwnerCharacter, TEXT("HammerOrbitRig"));
+	OrbitRig->SetupAttachment(OwnerCharacter->GetRootComponent());
+	OrbitRig->RegisterComponent();
+	return OrbitRig;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGHammerOrbitRigComponent::CanDriveHammer(const ARPGTranscendenceHammer* Hammer)
+{
+	return IsValid(Hammer) && Hammer->GetRootComponent() && !Hammer->IsReplicatingMovement();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGHammerOrbitRigComponent::AttachHammer(ARPGTranscendenceHammer* Hammer)
+{
+	if (!CanDriveHammer(Hammer))
+	{
+		return;
+	}
+
+	//The rig turns and scales with the formation, the hammer mesh keeps facing and sizing as it did when placed in world space
+	USceneComponent* HammerRoot = Hammer->GetRootComponent();
+	if (!HammerRoot->IsUsingAbsoluteRotation())
+	{
+		HammerRoot->SetUsingAbsoluteRotation(true);
+		AbsoluteRotationRoots.Add(HammerRoot);
+	}
+	if (!HammerRoot->IsUsingAbsoluteScale())
+	{
+		HammerRoot->SetUsingAbsoluteScale(true);
+		AbsoluteScaleRoots.Add(HammerRoot);
+	}
+	Hammer->AttachToComponent(this, FAttachmentTransformRules::KeepWorldTransform);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGHammerOrbitRigComponent::DetachHammer(ARPGTranscendenceHammer* Hammer)
+{
+	USceneComponent* HammerRoot = IsValid(Hammer) ? Hammer->GetRootComponent() : nullptr;
+	if (!HammerRoot || HammerRoot->GetAttachParent() != this)
+	{
+		return;
+	}
+
+	Hammer->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+	if (AbsoluteRotationRoots.Remove(HammerRoot) > 0)
+	{
+		HammerRoot->SetUsingAbsoluteRotation(false);
+	}
+	if (AbsoluteScaleRoots.Remove(HammerRoot) > 0)
+	{
+		HammerRoot->SetUsingAbsoluteScale(false);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGHammerOrbitRigComponent::SetHammerRigOffset(ARPGTranscendenceHammer* Hammer, const FVector& RigOffset)
+{
+	//Only the relative location is stored, the child transform is updated with the rig so the hammer is not moved twice
+	USceneComponent* HammerRoot = Hammer->GetRootComponent();
+	const float RigSpaceTolerance = RigOffsetTolerance / FMath::Max(GetRelativeScale3D().X, 1.f);
+	if (!HammerRoot->GetRelativeLocation().Equals(RigOffset, RigSpaceTolerance))
+	{
+		HammerRoot->SetRelativeLocation_Direct(RigOffset);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGHammerOrbitRigComponent::SetFormationTransform(const FQuat& FormationRotation, const float FormationRadius)
+{
+	//Absolute rotation and scale make the relative values the world ones, a single update propagates them and the pending offsets to the children
+	SetRelativeRotation_Direct(FormationRotation.Rotator());
+	SetRelativeScale3D_Direct(FVector(FormationRadius));
+	UpdateComponentToWorld(EUpdateTransformFlags::None, ETeleportType::TeleportPhysics);
+}
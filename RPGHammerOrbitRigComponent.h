@@ -0,0 +1,54 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "RPGHammerOrbitRigComponent.generated.h"
+
+class ARPGCharacterBase;
+class ARPGTranscendenceHammer;
+
+/**
+ * Pivot attached to the player that carries its orbiting hammers as children.
+ * The rotation of the rig is the phase of the group formation and its scale is the formation radius, the hammers in their
+ * formation slot keep a fixed unit offset and follow with a single hierarchical update per commit.
+ * Only the hammers outside their slot (spinning, re-layout) get a new offset, written in the same update as the rig.
+ */
+UCLASS(ClassGroup = (RPG))
+class ACTIONRPG_API URPGHammerOrbitRigComponent : public USceneComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	URPGHammerOrbitRigComponent();
+
+	/**Orbit rig of the player, created and attached to its root the first time*/
+	static URPGHammerOrbitRigComponent* FindOrAddOrbitRig(ARPGCharacterBase* OwnerCharacter);
+
+	/**Hammers replicating their movement keep a world placement, the rig only exists on each machine and cannot be an attach parent over the network*/
+	static bool CanDriveHammer(const ARPGTranscendenceHammer* Hammer);
+
+	/**Make the hammer a child of the rig keeping its world location, the hammer keeps its own world rotation and scale*/
+	void AttachHammer(ARPGTranscendenceHammer* Hammer);
+
+	/**Release the hammer where it is, called when it stops orbiting*/
+	void DetachHammer(ARPGTranscendenceHammer* Hammer);
+
+	/**Set the offset of the child hammer in rig space, skipped when it already is there. Applied by the next SetFormationTransform*/
+	void SetHammerRigOffset(ARPGTranscendenceHammer* Hammer, const FVector& RigOffset);
+
+	/**Turn and scale the rig to the formation, the rig and its children are updated once with the offsets set since the last call*/
+	void SetFormationTransform(const FQuat& FormationRotation, const float FormationRadius);
+
+protected:
+
+	/**World distance under which a relative offset is considered unchanged*/
+	UPROPERTY(EditAnywhere, Category = "Orbit")
+	float RigOffsetTolerance;
+
+	/**Hammer roots switched to absolute rotation or scale by the rig, restored when they are detached*/
+	TSet<const USceneComponent*> AbsoluteRotationRoots;
+	TSet<const USceneComponent*> AbsoluteScaleRoots;
+};
@@ -0,0 +1,12 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SergioTestContentClasses/RPGHammerTuningDataAsset.h"
+#include "SergioTestContentClasses/RPGHammerOrbitMath.h"
+
+URPGHammerTuningDataAsset::URPGHammerTuningDataAsset()
+{
+	SpinningProfile = RPGHammerOrbitMath::MakeSpinningProfile(OrbitProfile);
+	RotateAxisVector = FVector(0.f, 0.f, 1.0f);
+	MoveHammerToEnemySmoothValueRange = 2.0f;
+}
@@ -0,0 +1,66 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "RPGHammerTuningDataAsset.generated.h"
+
+/**Speed and radius limits of a hammer orbit*/
+USTRUCT(BlueprintType)
+struct FRPGHammerOrbitProfile
+{
+	GENERATED_BODY()
+
+	/**The minimum rotation speed that the hammers can have on the axis*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float MinRotationSpeedValue = 180.f;
+
+	/**The Maximum rotation speed that the hammers can have on the axis*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float MaxRotationSpeedValue = 350.f;
+
+	/**The minimum radius that the hammers can have around axis*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float MinRotationRadiusValue = 70.f;
+
+	/**The maximum radius that the hammers can have around axis*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float MaxRotationRadiusValue = 200.f;
+};
+
+/**
+ * Immutable tuning of a transcendence hammer, one asset shared by every hammer that references it.
+ * The hammers and the orbit states only keep a pointer to it, the per hammer state is only the dynamic values.
+ */
+UCLASS(BlueprintType)
+class ACTIONRPG_API URPGHammerTuningDataAsset : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	URPGHammerTuningDataAsset();
+
+	/**Limits of the normal orbit*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Orbit")
+	FRPGHammerOrbitProfile OrbitProfile;
+
+	/**Limits while the hammer is spinning, faster and tighter than the normal orbit*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Orbit")
+	FRPGHammerOrbitProfile SpinningProfile;
+
+	/**Which Axis will rotate in this case Z*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Orbit")
+	FVector RotateAxisVector;
+
+	/**This value allows to adjust the speed/smoothness of the movement with which hammer is moving to enemy*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Control")
+	float MoveHammerToEnemySmoothValueRange;
+
+	/**Profile of the current mode*/
+	const FRPGHammerOrbitProfile& GetProfile(const bool bIsInSpinningMode) const { return bIsInSpinningMode ? SpinningProfile : OrbitProfile; }
+
+	/**Tuning used by the hammers without asset, the values of the original hammer*/
+	static const URPGHammerTuningDataAsset* GetDefaultTuning() { return GetDefault<URPGHammerTuningDataAsset>(); }
+};
@@ -2,11 +2,18 @@
 
 
 #include "SergioTestContentClasses/RPGTranscendenceHammer.h"
+#include "SergioTestContentClasses/RPGTranscendenceHammerSubsystem.h"
+#include "SergioTestContentClasses/RPGFactionComponent.h"
+#include "SergioTestContentClasses/RPGHammerOrbitReplicationComponent.h"
+#include "SergioTestContentClasses/RPGHammerOrbitMath.h"
+#include "SergioTestContentClasses/RPGHammerTuningDataAsset.h"
+#include "SergioTestContentClasses/RPGTranscendenceStats.h"
 #include "RPGCharacterBase.h"
-#include "Kismet/KismetMathLibrary.h"
 #include "AbilitySystemGlobals.h"
 #include "Abilities/RPGGameplayAbility.h"
 
+DEFINE_LOG_CATEGORY_STATIC(LogRPGTranscendenceHammer, Log, All);
+
 // Sets default values
 ARPGTranscendenceHammer::ARPGTranscendenceHammer()
 {
@@ -15,28 +22,77 @@ ARPGTranscendenceHammer::ARPGTranscendenceHammer()
 
 	RotationAngleAxis = 0.f;
 	RotationDirection = -1.f;
-	RotateAxisVector = FVector(0.f, 0.f, 1.0f);
-	MinRotationSpeedValue = 180.f;
-	MaxRotationSpeedValue = 350.f;
-	MaxRotationRadiusValue = 200.f;
-	MinRotationRadiusValue = 70.f;
-	RotationSpeed = MinRotationSpeedValue;
-	RotationRadius = MinRotationRadiusValue;
+	HammerTuning = nullptr;
+	RotationSpeed = 180.f;
+	RotationRadius = 70.f;
 	LerpMoveHammertoEnemyValue = 0.F;
-	MoveHammerToEnemySmoothValueRange = 2.0f;
 
 	CurrentHamexIndex = 0;
 
-	bIsInSpinningMode = false;
 	bWasHammerUsed = false;
 	bIsHammerPreparingToUse = false;
 	bHasToHammerControl = false;
+	bIsClientSimulated = false;
 
 
 	PlayerCharacterRef = nullptr;
 	EnemyNPCRef = nullptr;
 
 	PreviewForwardVectorToCompare = FVector::ZeroVector;
+
+	OrbitSubsystem = nullptr;
+	HammerState = ERPGTranscendenceHammerState::Deactivated;
+
+	//Values of the original hammer, a loaded hammer that differs from them had its own tuning
+	RotateAxisVector_DEPRECATED = FVector(0.f, 0.f, 1.0f);
+	MinRotationSpeedValue_DEPRECATED = 180.f;
+	MaxRotationSpeedValue_DEPRECATED = 350.f;
+	MinRotationRadiusValue_DEPRECATED = 70.f;
+	MaxRotationRadiusValue_DEPRECATED = 200.f;
+	MoveHammerToEnemySmoothValueRange_DEPRECATED = 2.0f;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void ARPGTranscendenceHammer::PostLoad()
+{
+	Super::PostLoad();
+
+	if (IsValid(HammerTuning))
+	{
+		return;
+	}
+
+	FRPGHammerOrbitProfile SavedOrbitProfile;
+	SavedOrbitProfile.MinRotationSpeedValue = MinRotationSpeedValue_DEPRECATED;
+	SavedOrbitProfile.MaxRotationSpeedValue = MaxRotationSpeedValue_DEPRECATED;
+	SavedOrbitProfile.MinRotationRadiusValue = MinRotationRadiusValue_DEPRECATED;
+	SavedOrbitProfile.MaxRotationRadiusValue = MaxRotationRadiusValue_DEPRECATED;
+
+	const URPGHammerTuningDataAsset* DefaultTuning = URPGHammerTuningDataAsset::GetDefaultTuning();
+	const bool bHasOwnTuning = SavedOrbitProfile.MinRotationSpeedValue != DefaultTuning->OrbitProfile.MinRotationSpeedValue
+		|| SavedOrbitProfile.MaxRotationSpeedValue != DefaultTuning->OrbitProfile.MaxRotationSpeedValue
+		|| SavedOrbitProfile.MinRotationRadiusValue != DefaultTuning->OrbitProfile.MinRotationRadiusValue
+		|| SavedOrbitProfile.MaxRotationRadiusValue != DefaultTuning->OrbitProfile.MaxRotationRadiusValue
+		|| RotateAxisVector_DEPRECATED != DefaultTuning->RotateAxisVector
+		|| MoveHammerToEnemySmoothValueRange_DEPRECATED != DefaultTuning->MoveHammerToEnemySmoothValueRange;
+	if (!bHasOwnTuning)
+	{
+		return;
+	}
+
+	//Transient: rebuilt on every load until a shared tuning asset is assigned to the hammer
+	URPGHammerTuningDataAsset* MigratedTuning = NewObject<URPGHammerTuningDataAsset>(this, NAME_None, RF_Transient);
+	MigratedTuning->OrbitProfile = SavedOrbitProfile;
+	MigratedTuning->SpinningProfile = RPGHammerOrbitMath::MakeSpinningProfile(SavedOrbitProfile);
+	MigratedTuning->RotateAxisVector = RotateAxisVector_DEPRECATED;
+	MigratedTuning->MoveHammerToEnemySmoothValueRange = MoveHammerToEnemySmoothValueRange_DEPRECATED;
+	HammerTuning = MigratedTuning;
+
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		UE_LOG(LogRPGTranscendenceHammer, Warning, TEXT("%s still has its own orbit tuning, move it to a hammer tuning data asset and assign HammerTuning"), *GetClass()->GetName());
+	}
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -46,7 +102,30 @@ void ARPGTranscendenceHammer::BeginPlay()
 
 	TrySetupReferences();
 
-	ActivatedHammer();	
+	//Pooled hammers are spawned without owner and wait deactivated until they are acquired
+	if (IsValid(PlayerCharacterRef))
+	{
+		ActivatedHammer();
+	}
+	else
+	{
+		DeactivatedHammer();
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void ARPGTranscendenceHammer::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopOrbitMovement();
+
+	//Leave the stepped states without waiting for the weak reference of the subsystem to expire
+	if (HammerState == ERPGTranscendenceHammerState::MovingToEnemy)
+	{
+		OnExitHammerState(HammerState);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -60,133 +139,302 @@ void ARPGTranscendenceHammer::TrySetupReferences()
 
 void ARPGTranscendenceHammer::ActivatedHammer()
 {
-    bIsHammerActive = true;
-	GetWorldTimerManager().SetTimer(OrbitAroundHandle, this, &ARPGTranscendenceHammer::HammersOrbitMovement, GetWorld()->GetDeltaSeconds(), true);
+	TrySetupReferences();
+
+	SetActorHiddenInGame(false);
+
+	//Nothing gameplay relevant collides with an orbiting hammer, the collision is only enabled for the control phase
+	SetActorEnableCollision(false);
+
+	StartOrbitMovement();
+
+	SetHammerState(ERPGTranscendenceHammerState::Orbiting);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 void ARPGTranscendenceHammer::DeactivatedHammer(AActor* DeactivatedByRef)
 {
-    SetActorHiddenInGame(true);
-	
+	HideHammer();
+
+	SetHammerState(ERPGTranscendenceHammerState::Deactivated);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void ARPGTranscendenceHammer::HideHammer()
+{
+	SetActorHiddenInGame(true);
+
 	SetActorEnableCollision(false);
 
-	const bool bValidOrbitHandleTurnOff = OrbitAroundHandle.IsValid() && GetWorldTimerManager().IsTimerActive(OrbitAroundHandle);
-	if (bValidOrbitHandleTurnOff)
+	StopOrbitMovement();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool ARPGTranscendenceHammer::IsValidHammerStateTransition(const ERPGTranscendenceHammerState FromState, const ERPGTranscendenceHammerState ToState)
+{
+	//The hammer can always be hidden and returned to the pool
+	if (ToState == ERPGTranscendenceHammerState::Deactivated)
 	{
-		GetWorldTimerManager().ClearTimer(OrbitAroundHandle);
+		return true;
 	}
 
-	const bool bValidMoveHandleTurnOff = MoveHammerToEnemyHandle.IsValid() && GetWorldTimerManager().IsTimerActive(MoveHammerToEnemyHandle);
-	if (bValidMoveHandleTurnOff)
+	switch (FromState)
 	{
-		GetWorldTimerManager().ClearTimer(MoveHammerToEnemyHandle);
+	case ERPGTranscendenceHammerState::Deactivated:
+		return ToState == ERPGTranscendenceHammerState::Orbiting;
+
+	case ERPGTranscendenceHammerState::Orbiting:
+		return ToState == ERPGTranscendenceHammerState::Spinning;
+
+	case ERPGTranscendenceHammerState::Spinning:
+		return ToState == ERPGTranscendenceHammerState::Orbiting || ToState == ERPGTranscendenceHammerState::Projectile || ToState == ERPGTranscendenceHammerState::MovingToEnemy;
+
+	case ERPGTranscendenceHammerState::MovingToEnemy:
+		return ToState == ERPGTranscendenceHammerState::Controlling;
+
+	//A used hammer only waits to be deactivated
+	default:
+		return false;
 	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-	const bool bValidSpinningHandleTurnOff = SpinningModeHandle.IsValid() && GetWorldTimerManager().IsTimerActive(SpinningModeHandle);
-	if (bValidMoveHandleTurnOff)
+bool ARPGTranscendenceHammer::SetHammerState(const ERPGTranscendenceHammerState NewHammerState)
+{
+	if (HammerState == NewHammerState)
 	{
-		GetWorldTimerManager().ClearTimer(SpinningModeHandle);
+		return true;
 	}
 
-	bIsHammerActive = false;
+	if (!ensureMsgf(IsValidHammerStateTransition(HammerState, NewHammerState), TEXT("%s: invalid hammer state transition %s -> %s"), *GetName(),
+		*UEnum::GetValueAsString(HammerState), *UEnum::GetValueAsString(NewHammerState)))
+	{
+		return false;
+	}
+
+	RPGTranscendenceTrace::OutputHammerStateChange(this, HammerState, NewHammerState);
+
+	const ERPGTranscendenceHammerState OldHammerState = HammerState;
+	OnExitHammerState(OldHammerState);
+	HammerState = NewHammerState;
+	OnEnterHammerState(NewHammerState);
+	return true;
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-void ARPGTranscendenceHammer::HammersOrbitMovement()
+void ARPGTranscendenceHammer::OnEnterHammerState(const ERPGTranscendenceHammerState EnteredState)
 {
- 	
-	if (!IsValid(PlayerCharacterRef))
+	switch (EnteredState)
 	{
-		TrySetupReferences();
-		return;
+	case ERPGTranscendenceHammerState::MovingToEnemy:
+	{
+		//Stepped by the subsystem at the same fixed step as the orbit, so the approach takes the same time at any frame rate
+		LerpMoveHammertoEnemyValue = 0.f;
+		URPGTranscendenceHammerSubsystem* HammerSubsystem = FindOrbitSubsystem();
+		if (IsValid(HammerSubsystem))
+		{
+			HammerSubsystem->AddSteppedHammer(this);
+		}
+		break;
 	}
-	
-	if (GetRotationValidVariance() || bIsInSpinningMode)
+
+	default:
+		break;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void ARPGTranscendenceHammer::OnExitHammerState(const ERPGTranscendenceHammerState ExitedState)
+{
+	switch (ExitedState)
 	{
-		ContractedRotation();
+	case ERPGTranscendenceHammerState::MovingToEnemy:
+		if (IsValid(OrbitSubsystem))
+		{
+			OrbitSubsystem->RemoveSteppedHammer(this);
+		}
+		break;
+
+	default:
+		break;
 	}
-	else
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void ARPGTranscendenceHammer::UpdateHammerState(const float StepSeconds)
+{
+	switch (HammerState)
+	{
+	case ERPGTranscendenceHammerState::MovingToEnemy:
+		MoveToEnemy(StepSeconds);
+		break;
+
+	//Orbiting and spinning are simulated by the orbit subsystem, the other states only react to events
+	default:
+		break;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void ARPGTranscendenceHammer::ResetHammerState()
+{
+	DeactivatedHammer();
+
+	//Release the controlled enemy in case the hammer was attached to it
+	if (IsValid(EnemyNPCRef))
 	{
-		ExpandedRotation();
+		EnemyNPCRef->OnDestroyed.RemoveDynamic(this, &ARPGTranscendenceHammer::DeactivatedHammer);
 	}
+	DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+
+	const ARPGTranscendenceHammer* DefaultHammer = GetClass()->GetDefaultObject<ARPGTranscendenceHammer>();
+	RotationAngleAxis = DefaultHammer->RotationAngleAxis;
+	RotationDirection = DefaultHammer->RotationDirection;
+	RotationSpeed = DefaultHammer->RotationSpeed;
+	RotationRadius = DefaultHammer->RotationRadius;
+	PreviewForwardVectorToCompare = DefaultHammer->PreviewForwardVectorToCompare;
+	LerpMoveHammertoEnemyValue = 0.f;
+	CurrentHamexIndex = 0;
 
-	/*Calculate the new AngleAxis*/
-	PreviewForwardVectorToCompare = PlayerCharacterRef->GetActorForwardVector();
-	RotationAngleAxis = ((RotationSpeed *  GetWorld()->GetDeltaSeconds()) * RotationDirection) + RotationAngleAxis;
+	bWasHammerUsed = false;
+	bIsHammerPreparingToUse = false;
+	bHasToHammerControl = false;
+	bIsClientSimulated = false;
+
+	EnemyNPCRef = nullptr;
+	PlayerCharacterRef = nullptr;
+	SetOwner(nullptr);
+}
 
-	/*Refreshes Axis value don't exceed 360 degrees */
-	const bool HasToResetAngleAxis = RotationAngleAxis >= 360.f || RotationAngleAxis <= -360.f;
-	if (HasToResetAngleAxis)
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+URPGTranscendenceHammerSubsystem* ARPGTranscendenceHammer::FindOrbitSubsystem()
+{
+	if (!IsValid(OrbitSubsystem))
 	{
-		RotationAngleAxis = 0.0f;
+		OrbitSubsystem = GetWorld()->GetSubsystem<URPGTranscendenceHammerSubsystem>();
 	}
 
-	/*Calculate the new position based on the angle axis about the vector */
-	const FVector VectorRadius = FVector(RotationRadius, 0.f, 0.f);
-	const FVector RotateNewLocation = VectorRadius.RotateAngleAxis(RotationAngleAxis, RotateAxisVector);
-	const FVector HammerNewLocation = PlayerCharacterRef->GetActorLocation() + RotateNewLocation;
-	SetActorLocation(HammerNewLocation);	
+	return OrbitSubsystem;
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-bool ARPGTranscendenceHammer::GetRotationValidVariance()
-{  
-    // Is the player is in a sufficiently accurate and valid rotation to update direccion?
-	CurrentDotAngleVariance = FVector::DotProduct(PreviewForwardVectorToCompare , PlayerCharacterRef->GetActorRightVector());
-	const bool bIsNearly = FMath::IsNearlyEqual(CurrentDotAngleVariance, 0.f, 0.016f);
-	
-	return bIsNearly;	
+void ARPGTranscendenceHammer::StartOrbitMovement()
+{
+	if (!IsValid(FindOrbitSubsystem()) || !IsValid(PlayerCharacterRef))
+	{
+		return;
+	}
+
+	OrbitSubsystem->RegisterHammer(this, PlayerCharacterRef, CurrentHamexIndex, MakeOrbitState());
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-void ARPGTranscendenceHammer::ExpandedRotation()
-{    
-	
-	RotationSpeed = FMath::Clamp(RotationSpeed + 3.f, MinRotationSpeedValue, MaxRotationSpeedValue);
-	RotationRadius = FMath::Clamp(RotationRadius + 1, MinRotationRadiusValue, MaxRotationRadiusValue);
-	if (CurrentDotAngleVariance > 0.f)
+FRPGHammerOrbitState ARPGTranscendenceHammer::MakeOrbitState() const
+{
+	FRPGHammerOrbitState OrbitState;
+	OrbitState.RotationAngleAxis = RotationAngleAxis;
+	OrbitState.RotationDirection = RotationDirection;
+	OrbitState.RotationSpeed = RotationSpeed;
+	OrbitState.RotationRadius = RotationRadius;
+	OrbitState.Tuning = GetHammerTuning();
+	OrbitState.PreviewForwardVectorToCompare = PreviewForwardVectorToCompare;
+	OrbitState.bIsInSpinningMode = IsInSpinningMode();
+	return OrbitState;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void ARPGTranscendenceHammer::StopOrbitMovement()
+{
+	if (!IsValid(OrbitSubsystem))
 	{
-		RotationDirection = -1.0f;
+		return;
 	}
-	else
+
+	//Keep the last simulated values so the hammer continues from where it was
+	FRPGHammerOrbitState LastOrbitState;
+	if (OrbitSubsystem->UnregisterHammer(this, PlayerCharacterRef, CurrentHamexIndex, &LastOrbitState))
 	{
-		RotationDirection = 1.0f;
+		RotationAngleAxis = LastOrbitState.RotationAngleAxis;
+		RotationDirection = LastOrbitState.RotationDirection;
+		RotationSpeed = LastOrbitState.RotationSpeed;
+		RotationRadius = LastOrbitState.RotationRadius;
+		PreviewForwardVectorToCompare = LastOrbitState.PreviewForwardVectorToCompare;
 	}
 }
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+FRPGHammerOrbitState* ARPGTranscendenceHammer::GetOrbitState() const
+{
+	return IsValid(OrbitSubsystem) ? OrbitSubsystem->FindOrbitState(PlayerCharacterRef, CurrentHamexIndex) : nullptr;
+}
+
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-void ARPGTranscendenceHammer::ContractedRotation()
+float ARPGTranscendenceHammer::GetRotationDirection() const
 {
-	RotationDirection = RotationDirection;
-	RotationSpeed = FMath::Clamp(RotationSpeed - 1.f, MinRotationSpeedValue, MaxRotationSpeedValue);
-	RotationRadius = FMath::Clamp(RotationRadius - 1, MinRotationRadiusValue, MaxRotationRadiusValue);	
+	const FRPGHammerOrbitState* OrbitState = GetOrbitState();
+	return OrbitState ? OrbitState->RotationDirection : RotationDirection;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+ERPGHammerSignificance ARPGTranscendenceHammer::GetSignificance() const
+{
+	return IsValid(OrbitSubsystem) ? OrbitSubsystem->GetOwnerSignificance(PlayerCharacterRef) : ERPGHammerSignificance::High;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+const URPGHammerTuningDataAsset* ARPGTranscendenceHammer::GetHammerTuning() const
+{
+	return IsValid(HammerTuning) ? HammerTuning : URPGHammerTuningDataAsset::GetDefaultTuning();
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 void ARPGTranscendenceHammer::StartSpinningMode(const bool bHasToUse ,const bool bIsInControlMode, const float NewAngleAxis)
 {
+  //Spinning again only changes the use and the angle of the current spin
+  if (!SetHammerState(ERPGTranscendenceHammerState::Spinning))
+  {
+	  return;
+  }
+
   bIsHammerPreparingToUse = bHasToUse; 
   bHasToHammerControl = bIsInControlMode;
-  RotationAngleAxis = RotationAngleAxis + NewAngleAxis;
-  bIsInSpinningMode = true;
 
-  //Adjust the speed and radius to create the spinning status correctly
-  MinRotationSpeedValue = MinRotationSpeedValue * 6.F;
-  MinRotationRadiusValue = MinRotationRadiusValue / 2.F;
-
-  GetWorldTimerManager().SetTimer(SpinningModeHandle, this, &ARPGTranscendenceHammer::CheckSpinningModeState, GetWorld()->GetDeltaSeconds(), true , 0.20f);
+  //The orbit subsystem checks the spinning state on every simulation step after a small delay
+  if (IsValid(OrbitSubsystem))
+  {
+	  OrbitSubsystem->StartOrbitSpinning(PlayerCharacterRef, CurrentHamexIndex, bHasToUse, NewAngleAxis);
+  }
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-void ARPGTranscendenceHammer::CheckSpinningModeState()
+void ARPGTranscendenceHammer::CheckSpinningModeState(const bool bIsInFireWindow)
 {
+	RPG_TRANSCENDENCE_SCOPE(STAT_RPGTranscendence_CheckSpinningModeState);
+
+	//A check queued before the hammer left the spinning state
+	if (HammerState != ERPGTranscendenceHammerState::Spinning)
+	{
+		return;
+	}
+
 	if (!bIsHammerPreparingToUse)
 	{
 	   StopSpinningMode();
@@ -194,9 +442,7 @@ void ARPGTranscendenceHammer::CheckSpinningModeState()
 	}
 
 	//Has to check the world stay in the 20 degrees front actor zone to allow use the hammer
-	const float AbsoluteAngleAxis = FMath::Abs(RotationAngleAxis);
-	const bool bValidRotationAngle = FMath::IsNearlyEqual(AbsoluteAngleAxis , 120.f, 5.f);
-	if (!bValidRotationAngle)
+	if (!bIsInFireWindow)
 	{
 		return;
 	}
@@ -218,26 +464,58 @@ void ARPGTranscendenceHammer::CheckSpinningModeState()
 
 void ARPGTranscendenceHammer::StopSpinningMode()
 {
-	if (SpinningModeHandle.IsValid() && bIsInSpinningMode)
+	//Used hammers already left the spinning state and the orbit to projectile or control
+	if (!IsInSpinningMode())
 	{
-		GetWorldTimerManager().ClearTimer(SpinningModeHandle);
+		return;
+	}
 
-		bIsInSpinningMode = false;
+	if (IsValid(OrbitSubsystem))
+	{
+		OrbitSubsystem->StopOrbitSpinning(PlayerCharacterRef, CurrentHamexIndex);
+	}
 
-		//Adjust back the speed and radius to revert the spinning status correctly
-		MinRotationSpeedValue = MinRotationSpeedValue / 6.F;
-		MinRotationRadiusValue = MinRotationRadiusValue * 2;		
-	}	
+	SetHammerState(ERPGTranscendenceHammerState::Orbiting);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void ARPGTranscendenceHammer::MarkUsedByServer()
+{
+	if (bWasHammerUsed)
+	{
+		return;
+	}
+
+	bIsHammerPreparingToUse = false;
+	StopSpinningMode();
+	DeactivatedHammer();
+	bWasHammerUsed = true;
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 void ARPGTranscendenceHammer::ProjectileHammerCase()
 {
-      DeactivatedHammer();
+      HideHammer();
 	  
 	  bWasHammerUsed = true;
 
+	  SetHammerState(ERPGTranscendenceHammerState::Projectile);
+
+	  //The projectile is a replicated actor of the server, the local copies only disappear
+	  if (bIsClientSimulated)
+	  {
+		  return;
+	  }
+
+	  //Clients simulating this orbit hide their copy at the same time
+	  URPGHammerOrbitReplicationComponent* OrbitReplication = IsValid(PlayerCharacterRef) ? PlayerCharacterRef->FindComponentByClass<URPGHammerOrbitReplicationComponent>() : nullptr;
+	  if (IsValid(OrbitReplication) && HasAuthority())
+	  {
+		  OrbitReplication->NotifyHammerFired(CurrentHamexIndex);
+	  }
+
 	  /*BP Event Use it to Spawn "BP Projectile Hammer Class" Because the base RPG Projectile inheritance system and classes was made only in BP */
 	  BP_ProjectileHammerCase();
 }
@@ -251,11 +529,13 @@ void ARPGTranscendenceHammer::StartMoveToEnemyCase()
         return;
 	}
 
-	GetWorldTimerManager().ClearTimer(OrbitAroundHandle);
-	bIsHammerActive = false;
+	StopOrbitMovement();
 	bWasHammerUsed = true;
 
-	GetWorldTimerManager().SetTimer(MoveHammerToEnemyHandle, this, &ARPGTranscendenceHammer::MoveToEnemy, GetWorld()->GetDeltaSeconds(), true);
+	//Full collision while the hammer travels to and holds the enemy
+	SetActorEnableCollision(true);
+
+	SetHammerState(ERPGTranscendenceHammerState::MovingToEnemy);
 	
 	if (!EnemyNPCRef->IsPendingKill())
 	{
@@ -269,8 +549,10 @@ void ARPGTranscendenceHammer::StartMoveToEnemyCase()
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-void ARPGTranscendenceHammer::MoveToEnemy()
+void ARPGTranscendenceHammer::MoveToEnemy(const float StepSeconds)
 {
+	RPG_TRANSCENDENCE_SCOPE(STAT_RPGTranscendence_MoveToEnemy);
+
 	if (!IsValid(EnemyNPCRef))
 	{
 		DeactivatedHammer();
@@ -278,12 +560,14 @@ void ARPGTranscendenceHammer::MoveToEnemy()
 	}
 
 	//Calculation of new world location between the hammer and the enemy
-	LerpMoveHammertoEnemyValue = LerpMoveHammertoEnemyValue + GetWorld()->GetDeltaSeconds();
-	const float LerpAlpha = UKismetMathLibrary::MapRangeClamped(LerpMoveHammertoEnemyValue , 0.f , MoveHammerToEnemySmoothValueRange, 0.f, 1.f);
+	LerpMoveHammertoEnemyValue = LerpMoveHammertoEnemyValue + StepSeconds;
+	const float SmoothValueRange = GetHammerTuning()->MoveHammerToEnemySmoothValueRange;
+	const float LerpAlpha = RPGHammerOrbitMath::MoveToEnemyAlpha(LerpMoveHammertoEnemyValue, SmoothValueRange);
 	const FVector NewLocationHammer = FMath::Lerp(GetActorLocation(), EnemyNPCRef->GetActorLocation(), LerpAlpha);
-	SetActorLocation(NewLocationHammer);
+	//Overlaps stay on for the control phase, the kinematic approach does not need a physics velocity
+	SetActorLocation(NewLocationHammer, false, nullptr, ETeleportType::TeleportPhysics);
 
-	const bool bCloseEnough = LerpAlpha >= (0.3 / MoveHammerToEnemySmoothValueRange);
+	const bool bCloseEnough = RPGHammerOrbitMath::IsMoveToEnemyCloseEnough(LerpAlpha, SmoothValueRange);
 	if (bCloseEnough)
 	{	    
 		StopMoveToEnemy();
@@ -294,11 +578,15 @@ void ARPGTranscendenceHammer::MoveToEnemy()
 
 void ARPGTranscendenceHammer::StopMoveToEnemy()
 {
-    //The NPC becomes "Ally", in case the project has actors with more tag, a better method of search and replacement should be made.
-	EnemyNPCRef->Tags[0] = FName(TEXT("Player"));
+    //The NPC becomes "Ally", decided by the server hammer only
+	URPGFactionComponent* EnemyFaction = bIsClientSimulated ? nullptr : URPGFactionComponent::FindOrAddFactionComponent(EnemyNPCRef);
+	if (IsValid(EnemyFaction))
+	{
+		EnemyFaction->SetControlledByPlayer(true);
+	}
 
 	AttachToActor(EnemyNPCRef , FAttachmentTransformRules::SnapToTargetNotIncludingScale);
-	GetWorldTimerManager().ClearTimer(MoveHammerToEnemyHandle);
+	SetHammerState(ERPGTranscendenceHammerState::Controlling);
 	//Small Adjustment that allow Fit Hammer(Create a socket is the right)
 	AddActorLocalOffset(FVector(0.f , 0.f , 80.f), false);
 }
@@ -10,11 +10,30 @@
 class ARPGCharacterBase;
 class USceneComponent;
 class UStaticMesh;
+class URPGTranscendenceHammerSubsystem;
+class URPGHammerTuningDataAsset;
+struct FRPGHammerOrbitState;
+enum class ERPGHammerSignificance : uint8;
+
+/**Lifecycle of a transcendence hammer, see ARPGTranscendenceHammer::IsValidHammerStateTransition for the allowed changes*/
+UENUM(BlueprintType)
+enum class ERPGTranscendenceHammerState : uint8
+{
+	Deactivated,
+	Orbiting,
+	Spinning,
+	Projectile,
+	MovingToEnemy,
+	Controlling
+};
 
 UCLASS()
 class ACTIONRPG_API ARPGTranscendenceHammer : public AActor
 {
 	GENERATED_BODY()
+
+	friend class URPGTranscendenceHammerSubsystem;
+
 public:
 
 	// Sets default values for this actor's properties
@@ -30,9 +49,9 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Properties|HammerRotation")
 	float RotationDirection;
 
-	/**Which Axis will rotate in this case Z*/
+	/**Shared orbit limits, spinning profile, axis and control tuning, the defaults of the original hammer when not set*/
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Properties|HammerRotation")
-	FVector RotateAxisVector;
+	URPGHammerTuningDataAsset* HammerTuning;
 
 	/**The speed at which the hammer rotates*/
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Properties|HammerRotation")
@@ -46,31 +65,6 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Properties|HammerRotation")
 	FVector PreviewForwardVectorToCompare;
 
-	/**The minimum rotation speed that the hammers can have on the axis*/
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Properties|HammerRotation")
-	float MinRotationSpeedValue;
-
-	/**The Maximum rotation speed that the hammers can have on the axis*/
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Properties|HammerRotation")
-	float MaxRotationSpeedValue;
-
-	/**The minimum radius that the hammers can have around axis*/
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Properties|HammerRotation")
-	float MinRotationRadiusValue;
-
-	/**The maximum radius that the hammers can have around axis*/
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Properties|HammerRotation")
-	float MaxRotationRadiusValue;
-
-	UPROPERTY()
-	FTimerHandle OrbitAroundHandle;
-
-	UPROPERTY()
-	FTimerHandle MoveHammerToEnemyHandle;
-
-	UPROPERTY()
-	FTimerHandle  SpinningModeHandle;
-
 	/**Player Ref*/
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite , Category = "Properties| References")
 	ARPGCharacterBase* PlayerCharacterRef;
@@ -79,69 +73,86 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Properties| References")
 	ARPGCharacterBase* EnemyNPCRef;
 	
-	/**If it is true the hammer is rotanting in spinning mode and preparing to use it*/
-	UPROPERTY(BlueprintReadWrite)
-	uint8 bIsInSpinningMode : 1;
-
 	/**If it is true the hammer has already been used in fire o control case */
 	UPROPERTY(BlueprintReadOnly )
 	uint8 bWasHammerUsed : 1;
 
-	/**If it is true the hammer is preparing to use */
+	/**If it is true the hammer is preparing to use, the spinning state fires it instead of returning to the orbit*/
 	UPROPERTY(BlueprintReadOnly)
 	uint8 bIsHammerPreparingToUse : 1;
 
-	/**Is the Hammer active?*/
+	/**Is the Hammer to control enemys? Only read when the spinning hammer reaches the fire window*/
 	UPROPERTY(BlueprintReadOnly)
-	uint8 bIsHammerActive : 1;
+	uint8 bHasToHammerControl : 1;
 
-	/**Is the Hammer to control enemys?*/
+	/**Local copy of a server hammer, only visual: it does not spawn projectiles nor change factions*/
 	UPROPERTY(BlueprintReadOnly)
-	uint8 bHasToHammerControl : 1;
+	uint8 bIsClientSimulated : 1;
+
+	/**Current lifecycle state, only changed through SetHammerState and traced on the transcendence channel*/
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Properties")
+	ERPGTranscendenceHammerState HammerState;
 
 	/**The current index of the hammer in the main Array on the ability "GA_Transcendence*/
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly , Category = "Properties")
 	int32 CurrentHamexIndex;
 
-	/**This value allows to adjust the speed]/smoothness of the movement with which hammer is moving toenemy*/
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Properties|HammerRotation")
-	float MoveHammerToEnemySmoothValueRange;
-
 	/** Save the current value of the Lerp*/
 	float LerpMoveHammertoEnemyValue;
-    
-	/**Variance Player Angle */
-	float CurrentDotAngleVariance;
+
+	/**World manager that drives the orbit of all the active hammers*/
+	UPROPERTY()
+	URPGTranscendenceHammerSubsystem* OrbitSubsystem;
+
+	/**Tuning saved on the hammer before HammerTuning existed, only read by PostLoad to keep the values of older Blueprint hammers*/
+	UPROPERTY()
+	FVector RotateAxisVector_DEPRECATED;
+
+	UPROPERTY()
+	float MinRotationSpeedValue_DEPRECATED;
+
+	UPROPERTY()
+	float MaxRotationSpeedValue_DEPRECATED;
+
+	UPROPERTY()
+	float MinRotationRadiusValue_DEPRECATED;
+
+	UPROPERTY()
+	float MaxRotationRadiusValue_DEPRECATED;
+
+	UPROPERTY()
+	float MoveHammerToEnemySmoothValueRange_DEPRECATED;
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Moves the per hammer tuning of older Blueprint hammers to a tuning object
+	virtual void PostLoad() override;
+
+	// Called when the hammer is destroyed or removed from the level
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	/** Try to SetUp the necessary references */
 	void TrySetupReferences();
 
-	/**Function that activates the Hammer and its main orbit functionality*/
-	void ActivatedHammer();
-
-	/**Function that deactivates the Hammer it does not destroy it, it only remains inactive.*/
-	/**@Param :"DeactivatedByRef "Necessary reference when it is called from the on destroy delegate. Nullptr by default */
-	UFUNCTION()
-	void DeactivatedHammer(AActor* DeactivatedByRef = nullptr);
+	/**Register the hammer in the orbit subsystem that updates the correct positioning of the hammers around the player*/
+	void StartOrbitMovement();
 
-	/**Adjust and updates the correct positioning of the hammers around the player*/
-	void HammersOrbitMovement();
+	/**Unregister the hammer from the orbit subsystem keeping the last orbit values*/
+	void StopOrbitMovement();
 
-	/**The Valid Variance distance lets me know when a player is rolling or walking in a sufficient direction to update the orbit direction of the hammers*/
-	bool GetRotationValidVariance();
+	/**Orbit subsystem of the world, found the first time it is needed*/
+	URPGTranscendenceHammerSubsystem* FindOrbitSubsystem();
 
-	/** Hammers Expanding on their own orbit*/
-	void ExpandedRotation();
+	/**Hide the hammer and stop its orbit, shared by the deactivated and the projectile states*/
+	void HideHammer();
 
-    /** Hammers Contrated on their own orbit*/
-	void ContractedRotation();
+	/**Current orbit state in the subsystem, nullptr if the hammer is not orbiting*/
+	FRPGHammerOrbitState* GetOrbitState() const;
 
-	/**Check when the hammer is an acceptable angle to shoot smoothly forward case*/
-	void CheckSpinningModeState();
+	/**Called by the orbit subsystem when the spinning hammer has to stop or reached an acceptable angle to shoot smoothly forward case*/
+	void CheckSpinningModeState(const bool bIsInFireWindow);
 
 	/**Stop Spinning the hammer and return to its orbital state*/
 	void StopSpinningMode();
@@ -157,13 +168,34 @@ protected:
 	void StartMoveToEnemyCase();
 
 	/**This function moves the hammer in the direction of the enemy in a fluid way to "control" it.*/
-	void MoveToEnemy();
+	void MoveToEnemy(const float StepSeconds);
 
 	/**Stop the move enemy update and adjust the attach hammer*/
 	void StopMoveToEnemy();
 
+	/**Change the lifecycle state running the exit and enter actions, returns false and keeps the state if the transition is not allowed*/
+	bool SetHammerState(const ERPGTranscendenceHammerState NewHammerState);
+
+	/**Actions of the state that is being entered or left*/
+	void OnEnterHammerState(const ERPGTranscendenceHammerState EnteredState);
+	void OnExitHammerState(const ERPGTranscendenceHammerState ExitedState);
+
+	/**Single update entry, called by the orbit subsystem on every fixed step while the state needs per step work*/
+	void UpdateHammerState(const float StepSeconds);
+
 public:
 
+	/**Function that activates the Hammer and its main orbit functionality*/
+	void ActivatedHammer();
+
+	/**Function that deactivates the Hammer it does not destroy it, it only remains inactive.*/
+	/**@Param :"DeactivatedByRef "Necessary reference when it is called from the on destroy delegate. Nullptr by default */
+	UFUNCTION()
+	void DeactivatedHammer(AActor* DeactivatedByRef = nullptr);
+
+	/**Deactivate the hammer and return all the orbit, spinning and control state to the defaults so it can be reused by the pool*/
+	void ResetHammerState();
+
 	/**Start Spinning the hammer and prepare to posible use it case*/
 	UFUNCTION(BlueprintCallable)
 	void StartSpinningMode(const bool bHasToUse, const bool bIsInControlMode, const float NewAngleAxis);
@@ -180,12 +212,30 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void SetCurrentHamerIndex(const int32 NewIndex) { CurrentHamexIndex = NewIndex; }
 
+	/**Transition table of the hammer lifecycle, any state can go back to deactivated*/
+	static bool IsValidHammerStateTransition(const ERPGTranscendenceHammerState FromState, const ERPGTranscendenceHammerState ToState);
+
+	/**Orbit state built from the current hammer values, the defaults when called on the class default object*/
+	FRPGHammerOrbitState MakeOrbitState() const;
+
+	/**Mark the hammer as a local visual copy simulated from the replicated orbit descriptor*/
+	void SetIsClientSimulated(const bool bNewIsClientSimulated) { bIsClientSimulated = bNewIsClientSimulated; }
+
+	/**The server already used this hammer, hide the local copy even if its own orbit did not reach the fire window*/
+	void MarkUsedByServer();
+
 	/**NewEnemyRef Setter Function */
 	UFUNCTION(BlueprintCallable)
 	void SetEnemyNPCRef(ARPGCharacterBase* NewEnemyRef) {EnemyNPCRef = NewEnemyRef;}
 
 	UFUNCTION(BlueprintCallable)
-	float GetRotationDirection() const { return RotationDirection;}
+	float GetRotationDirection() const;
+
+	/**Significance tier of the orbit of this hammer, lower tiers update at a reduced rate*/
+	ERPGHammerSignificance GetSignificance() const;
+
+	/**Tuning shared by the hammers of this class*/
+	const URPGHammerTuningDataAsset* GetHammerTuning() const;
 
 	UFUNCTION(BlueprintCallable)
 	bool GetWasHammerUsed() const { return bWasHammerUsed; }
@@ -193,6 +243,21 @@ public:
 	UFUNCTION(BlueprintCallable)
 	bool GetIsPreparingToUse() const { return bIsHammerPreparingToUse; }
 
+	UFUNCTION(BlueprintCallable)
+	ERPGTranscendenceHammerState GetHammerState() const { return HammerState; }
+
+	/**The hammer is rotating in spinning mode and preparing to possibly use it*/
+	UFUNCTION(BlueprintPure)
+	bool IsInSpinningMode() const { return HammerState == ERPGTranscendenceHammerState::Spinning; }
+
+	/**The hammer is orbiting the player, spinning or not*/
+	UFUNCTION(BlueprintPure)
+	bool IsHammerActive() const { return HammerState == ERPGTranscendenceHammerState::Orbiting || HammerState == ERPGTranscendenceHammerState::Spinning; }
+
 	UFUNCTION(BlueprintImplementableEvent , BlueprintCallable)
 	void BP_ToggleHammerVFX(const bool bHasToFireVFX);
+
+	/**The hammer joined an orbit after the activation frame, fade its visuals in over the given seconds*/
+	UFUNCTION(BlueprintImplementableEvent)
+	void BP_FadeInHammer(const float FadeInSeconds);
 };
\ No newline at end of file
@@ -0,0 +1,310 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SergioTestContentClasses/RPGTranscendenceHammerPool.h"
+#include "SergioTestContentClasses/RPGTranscendenceHammer.h"
+#include "SergioTestContentClasses/RPGTranscendenceStats.h"
+#include "RPGCharacterBase.h"
+
+static TAutoConsoleVariable<float> CVarRPGTranscendenceSpawnBudgetMs(
+	TEXT("RPG.Transcendence.SpawnBudgetMs"),
+	1.f,
+	TEXT("Milliseconds per frame the hammer pool can spend serving hammer requests and pre-warm spawns, at least one hammer is always served per frame."),
+	ECVF_Default);
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerPool::Tick(float DeltaTime)
+{
+	RPG_TRANSCENDENCE_SCOPE(STAT_RPGTranscendence_BudgetedHammerSpawns);
+
+	const double BudgetSeconds = CVarRPGTranscendenceSpawnBudgetMs.GetValueOnGameThread() / 1000.0;
+	const double StartSeconds = FPlatformTime::Seconds();
+	int32 NumServed = 0;
+
+	//The requests of the active abilities go first, the pre-warm only uses the budget they leave.
+	//The queue is popped by index and compacted once, a burst of requests is drained without shifting the array per request
+	while (GetNumPendingRequests() > 0 && (NumServed == 0 || FPlatformTime::Seconds() - StartSeconds < BudgetSeconds))
+	{
+		FRPGHammerSpawnRequest SpawnRequest = MoveTemp(SpawnRequests[FirstPendingRequest]);
+		FirstPendingRequest++;
+		ServeHammerRequest(SpawnRequest);
+		NumServed++;
+	}
+	CompactSpawnRequests();
+
+	while (bHasPendingPrewarm && (NumServed == 0 || FPlatformTime::Seconds() - StartSeconds < BudgetSeconds))
+	{
+		bHasPendingPrewarm = SpawnNextPrewarmHammer();
+		NumServed++;
+	}
+
+	PoolStats.NumPendingRequests = GetNumPendingRequests();
+	PoolStats.PeakFrameSpawnMs = FMath::Max(PoolStats.PeakFrameSpawnMs, static_cast<float>((FPlatformTime::Seconds() - StartSeconds) * 1000.0));
+	SET_DWORD_STAT(STAT_RPGTranscendence_PendingHammerRequests, GetNumPendingRequests());
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+ETickableTickType URPGTranscendenceHammerPool::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGTranscendenceHammerPool::IsTickable() const
+{
+	return GetNumPendingRequests() > 0 || bHasPendingPrewarm;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+TStatId URPGTranscendenceHammerPool::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(URPGTranscendenceHammerPool, STATGROUP_Tickables);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerPool::PrewarmHammers(TSubclassOf<ARPGTranscendenceHammer> HammerClass, const int32 NumHammers)
+{
+	if (!IsValid(HammerClass) || NumHammers <= 0)
+	{
+		return;
+	}
+
+	//The hammers are constructed by the next ticks within the spawn budget, not on the grant frame
+	FRPGHammerPoolBucket& Bucket = PoolBuckets.FindOrAdd(HammerClass);
+	Bucket.Capacity += NumHammers;
+	bHasPendingPrewarm = true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerPool::ReleasePrewarmedHammers(TSubclassOf<ARPGTranscendenceHammer> HammerClass, const int32 NumHammers)
+{
+	FRPGHammerPoolBucket* Bucket = PoolBuckets.Find(HammerClass);
+	if (!Bucket)
+	{
+		return;
+	}
+
+	Bucket->Capacity = FMath::Max(Bucket->Capacity - NumHammers, 0);
+	TrimBucket(*Bucket);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+ARPGTranscendenceHammer* URPGTranscendenceHammerPool::AcquireHammer(TSubclassOf<ARPGTranscendenceHammer> HammerClass, ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, const float InitialAngleAxis)
+{
+	if (!IsValid(HammerClass) || !IsValid(OwnerCharacter))
+	{
+		return nullptr;
+	}
+
+	FRPGHammerPoolBucket& Bucket = PoolBuckets.FindOrAdd(HammerClass);
+	PoolStats.NumAcquired++;
+
+	ARPGTranscendenceHammer* Hammer = nullptr;
+	while (!Hammer && Bucket.FreeHammers.Num() > 0)
+	{
+		ARPGTranscendenceHammer* CandidateHammer = Bucket.FreeHammers.Pop(false);
+		PoolStats.NumFree--;
+		if (IsValid(CandidateHammer))
+		{
+			Hammer = CandidateHammer;
+		}
+	}
+
+	const FTransform& OwnerTransform = OwnerCharacter->GetActorTransform();
+	if (Hammer)
+	{
+		PoolStats.NumHits++;
+
+		Hammer->SetOwner(OwnerCharacter);
+		Hammer->SetActorTransform(OwnerTransform, false, nullptr, ETeleportType::TeleportPhysics);
+		Hammer->SetRotationAnglesAxis(InitialAngleAxis);
+		Hammer->SetPreviewForwardVector(OwnerCharacter->GetActorForwardVector());
+		Hammer->SetCurrentHamerIndex(HammerIndex);
+		Hammer->ActivatedHammer();
+	}
+	else
+	{
+		PoolStats.NumMisses++;
+
+		Hammer = GetWorld()->SpawnActorDeferred<ARPGTranscendenceHammer>(HammerClass, OwnerTransform, OwnerCharacter, nullptr, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+		if (!IsValid(Hammer))
+		{
+			return nullptr;
+		}
+
+		Hammer->SetRotationAnglesAxis(InitialAngleAxis);
+		Hammer->SetPreviewForwardVector(OwnerCharacter->GetActorForwardVector());
+		Hammer->SetCurrentHamerIndex(HammerIndex);
+		Hammer->FinishSpawning(OwnerTransform);
+	}
+
+	Bucket.NumInUse++;
+	PoolStats.NumInUse++;
+	RefreshPeakPoolSize();
+
+	return Hammer;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerPool::RequestHammer(const UObject* Requester, TSubclassOf<ARPGTranscendenceHammer> HammerClass, ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, const float InitialAngleAxis, FOnRPGHammerAcquired OnAcquired)
+{
+	FRPGHammerSpawnRequest& SpawnRequest = SpawnRequests.AddDefaulted_GetRef();
+	SpawnRequest.Requester = Requester;
+	SpawnRequest.HammerClass = HammerClass;
+	SpawnRequest.OwnerCharacter = OwnerCharacter;
+	SpawnRequest.HammerIndex = HammerIndex;
+	SpawnRequest.InitialAngleAxis = InitialAngleAxis;
+	SpawnRequest.OnAcquired = MoveTemp(OnAcquired);
+
+	PoolStats.NumPendingRequests = GetNumPendingRequests();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGTranscendenceHammerPool::ServeHammerRequestNow(const UObject* Requester, const int32 HammerIndex)
+{
+	CompactSpawnRequests();
+	const int32 RequestIndex = SpawnRequests.IndexOfByPredicate([Requester, HammerIndex](const FRPGHammerSpawnRequest& SpawnRequest)
+	{
+		return SpawnRequest.HammerIndex == HammerIndex && SpawnRequest.Requester == Requester;
+	});
+	if (RequestIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	FRPGHammerSpawnRequest SpawnRequest = MoveTemp(SpawnRequests[RequestIndex]);
+	SpawnRequests.RemoveAt(RequestIndex, 1, false);
+	PoolStats.NumPendingRequests = GetNumPendingRequests();
+	ServeHammerRequest(SpawnRequest);
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerPool::CancelHammerRequests(const UObject* Requester)
+{
+	CompactSpawnRequests();
+	SpawnRequests.RemoveAll([Requester](const FRPGHammerSpawnRequest& SpawnRequest)
+	{
+		return SpawnRequest.Requester == Requester;
+	});
+	PoolStats.NumPendingRequests = GetNumPendingRequests();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerPool::ServeHammerRequest(FRPGHammerSpawnRequest& SpawnRequest)
+{
+	//The requester or the player may be gone since the request was queued
+	ARPGCharacterBase* OwnerCharacter = SpawnRequest.OwnerCharacter.Get();
+	if (!SpawnRequest.Requester.IsValid() || !IsValid(OwnerCharacter))
+	{
+		return;
+	}
+
+	ARPGTranscendenceHammer* Hammer = AcquireHammer(SpawnRequest.HammerClass, OwnerCharacter, SpawnRequest.HammerIndex, SpawnRequest.InitialAngleAxis);
+	SpawnRequest.OnAcquired.ExecuteIfBound(Hammer);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGTranscendenceHammerPool::SpawnNextPrewarmHammer()
+{
+	for (TPair<UClass*, FRPGHammerPoolBucket>& BucketPair : PoolBuckets)
+	{
+		FRPGHammerPoolBucket& Bucket = BucketPair.Value;
+		if (!IsValid(BucketPair.Key) || Bucket.FreeHammers.Num() + Bucket.NumInUse >= Bucket.Capacity)
+		{
+			continue;
+		}
+
+		ARPGTranscendenceHammer* PooledHammer = SpawnPooledHammer(BucketPair.Key);
+		if (!IsValid(PooledHammer))
+		{
+			//Do not retry every frame a class that cannot be spawned
+			Bucket.Capacity = Bucket.FreeHammers.Num() + Bucket.NumInUse;
+			return true;
+		}
+
+		Bucket.FreeHammers.Push(PooledHammer);
+		PoolStats.NumFree++;
+		RefreshPeakPoolSize();
+		return true;
+	}
+
+	return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerPool::ReleaseHammer(ARPGTranscendenceHammer* Hammer)
+{
+	if (!IsValid(Hammer))
+	{
+		return;
+	}
+
+	Hammer->ResetHammerState();
+
+	FRPGHammerPoolBucket& Bucket = PoolBuckets.FindOrAdd(Hammer->GetClass());
+	Bucket.FreeHammers.Push(Hammer);
+	Bucket.NumInUse = FMath::Max(Bucket.NumInUse - 1, 0);
+	PoolStats.NumInUse = FMath::Max(PoolStats.NumInUse - 1, 0);
+	PoolStats.NumFree++;
+
+	TrimBucket(Bucket);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+ARPGTranscendenceHammer* URPGTranscendenceHammerPool::SpawnPooledHammer(TSubclassOf<ARPGTranscendenceHammer> HammerClass)
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	//Without owner the hammer begins play deactivated and waits to be acquired
+	return GetWorld()->SpawnActor<ARPGTranscendenceHammer>(HammerClass, FTransform::Identity, SpawnParameters);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerPool::TrimBucket(FRPGHammerPoolBucket& Bucket)
+{
+	while (Bucket.FreeHammers.Num() > 0 && Bucket.FreeHammers.Num() + Bucket.NumInUse > Bucket.Capacity)
+	{
+		ARPGTranscendenceHammer* ExceedingHammer = Bucket.FreeHammers.Pop(false);
+		PoolStats.NumFree--;
+		if (IsValid(ExceedingHammer))
+		{
+			ExceedingHammer->Destroy();
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerPool::RefreshPeakPoolSize()
+{
+	PoolStats.PeakPoolSize = FMath::Max(PoolStats.PeakPoolSize, PoolStats.NumInUse + PoolStats.NumFree);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerPool::CompactSpawnRequests()
+{
+	//Also called while a request is served, by requesters serving or cancelling their other requests
+	if (FirstPendingRequest > 0)
+	{
+		SpawnRequests.RemoveAt(0, FirstPendingRequest, false);
+		FirstPendingRequest = 0;
+	}
+}
@@ -0,0 +1,169 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "RPGTranscendenceHammerPool.generated.h"
+
+class ARPGCharacterBase;
+class ARPGTranscendenceHammer;
+
+/**Called when a budgeted hammer request is served, nullptr if the hammer could not be spawned*/
+DECLARE_DELEGATE_OneParam(FOnRPGHammerAcquired, ARPGTranscendenceHammer*);
+
+/**Usage counters of the hammer pool*/
+USTRUCT(BlueprintType)
+struct FRPGHammerPoolStats
+{
+	GENERATED_BODY()
+
+	/**Number of hammers requested to the pool*/
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumAcquired = 0;
+
+	/**Requests served with an already constructed hammer*/
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumHits = 0;
+
+	/**Requests that had to spawn a new hammer*/
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumMisses = 0;
+
+	/**Hammers currently in use by an ability*/
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumInUse = 0;
+
+	/**Hammers currently waiting in the pool*/
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumFree = 0;
+
+	/**Maximum number of hammers (in use + free) the pool has managed at the same time*/
+	UPROPERTY(BlueprintReadOnly)
+	int32 PeakPoolSize = 0;
+
+	/**Hammer requests waiting for spawn budget*/
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumPendingRequests = 0;
+
+	/**Longest time in milliseconds the pool spent spawning and activating hammers in a single frame*/
+	UPROPERTY(BlueprintReadOnly)
+	float PeakFrameSpawnMs = 0.f;
+
+	float GetHitRate() const { return NumAcquired > 0 ? static_cast<float>(NumHits) / NumAcquired : 0.f; }
+};
+
+/**Free hammers of the same class*/
+USTRUCT()
+struct FRPGHammerPoolBucket
+{
+	GENERATED_BODY()
+
+	/**Inactive hammers ready to be reused*/
+	UPROPERTY()
+	TArray<ARPGTranscendenceHammer*> FreeHammers;
+
+	/**Number of hammers the abilities granted in this world expect to have available*/
+	int32 Capacity = 0;
+
+	/**Hammers of this class currently in use*/
+	int32 NumInUse = 0;
+};
+
+/**Hammer acquisition waiting for the spawn budget of a frame*/
+struct FRPGHammerSpawnRequest
+{
+	/**Object that made the request, used to cancel or serve its requests at once*/
+	TWeakObjectPtr<const UObject> Requester;
+
+	TSubclassOf<ARPGTranscendenceHammer> HammerClass;
+
+	TWeakObjectPtr<ARPGCharacterBase> OwnerCharacter;
+
+	int32 HammerIndex = INDEX_NONE;
+
+	float InitialAngleAxis = 0.f;
+
+	FOnRPGHammerAcquired OnAcquired;
+};
+
+/**
+ * Reuses the transcendence hammers across ability activations so activating and ending the ability
+ * does not construct and garbage collect one actor per hammer.
+ * Requested hammers and the pre-warm spawns are time sliced: every frame only uses RPG.Transcendence.SpawnBudgetMs.
+ */
+UCLASS()
+class ACTIONRPG_API URPGTranscendenceHammerPool : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/**Increase the expected capacity of the pool and spawn over the next frames the hammers needed to reach it, called when the ability is granted*/
+	void PrewarmHammers(TSubclassOf<ARPGTranscendenceHammer> HammerClass, const int32 NumHammers);
+
+	/**Decrease the expected capacity of the pool and destroy the free hammers that exceed it, called when the ability is removed*/
+	void ReleasePrewarmedHammers(TSubclassOf<ARPGTranscendenceHammer> HammerClass, const int32 NumHammers);
+
+	/**Get an active hammer orbiting the player at the given angle, reusing a pooled one when possible*/
+	ARPGTranscendenceHammer* AcquireHammer(TSubclassOf<ARPGTranscendenceHammer> HammerClass, ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, const float InitialAngleAxis);
+
+	/**Queue the acquisition of a hammer, served in request order within the spawn budget of the next frames*/
+	void RequestHammer(const UObject* Requester, TSubclassOf<ARPGTranscendenceHammer> HammerClass, ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, const float InitialAngleAxis, FOnRPGHammerAcquired OnAcquired);
+
+	/**Serve now the pending request of the hammer index, ignoring the budget, false if the requester had no request for it*/
+	bool ServeHammerRequestNow(const UObject* Requester, const int32 HammerIndex);
+
+	/**Drop the pending requests of the requester without calling them*/
+	void CancelHammerRequests(const UObject* Requester);
+
+	/**Deactivate the hammer, reset all its state and return it to the pool*/
+	void ReleaseHammer(ARPGTranscendenceHammer* Hammer);
+
+	UFUNCTION(BlueprintCallable)
+	FRPGHammerPoolStats GetPoolStats() const { return PoolStats; }
+
+	UFUNCTION(BlueprintCallable)
+	float GetPoolHitRate() const { return PoolStats.GetHitRate(); }
+
+protected:
+
+	/**Acquire the hammer of the request and call it back*/
+	void ServeHammerRequest(FRPGHammerSpawnRequest& SpawnRequest);
+
+	/**Spawn one free hammer for the first bucket under its capacity, false when every bucket is full*/
+	bool SpawnNextPrewarmHammer();
+
+	/**Spawn a new inactive hammer without owner*/
+	ARPGTranscendenceHammer* SpawnPooledHammer(TSubclassOf<ARPGTranscendenceHammer> HammerClass);
+
+	/**Destroy the free hammers that exceed the bucket capacity*/
+	void TrimBucket(FRPGHammerPoolBucket& Bucket);
+
+	void RefreshPeakPoolSize();
+
+	/**Drop the requests already served from the front of the queue in a single move*/
+	void CompactSpawnRequests();
+
+	int32 GetNumPendingRequests() const { return SpawnRequests.Num() - FirstPendingRequest; }
+
+	UPROPERTY()
+	TMap<UClass*, FRPGHammerPoolBucket> PoolBuckets;
+
+	/**Requests in arrival order, the ones before FirstPendingRequest were served this frame and are removed once at the end of the tick*/
+	TArray<FRPGHammerSpawnRequest> SpawnRequests;
+	int32 FirstPendingRequest = 0;
+
+	/**Some bucket is still below its capacity*/
+	bool bHasPendingPrewarm = false;
+
+	FRPGHammerPoolStats PoolStats;
+};
@@ -0,0 +1,1287 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SergioTestContentClasses/RPGTranscendenceHammerSubsystem.h"
+#include "SergioTestContentClasses/RPGTranscendenceHammer.h"
+#include "SergioTestContentClasses/RPGHammerOrbitKernel.h"
+#include "SergioTestContentClasses/RPGHammerOrbitMath.h"
+#include "SergioTestContentClasses/RPGHammerOrbitRigComponent.h"
+#include "SergioTestContentClasses/RPGTranscendenceStats.h"
+#include "RPGCharacterBase.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/World.h"
+#include "Async/ParallelFor.h"
+
+static TAutoConsoleVariable<float> CVarRPGTranscendenceOrbitFixedHz(
+	TEXT("RPG.Transcendence.OrbitFixedHz"),
+	60.f,
+	TEXT("Rate in Hz of the fixed step hammer orbit simulation, the hammers are interpolated between steps for display. 0 simulates once per frame with the frame delta."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarRPGTranscendenceOrbitMaxStepsPerFrame(
+	TEXT("RPG.Transcendence.OrbitMaxStepsPerFrame"),
+	4,
+	TEXT("Maximum number of fixed orbit steps simulated in a single frame."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarRPGTranscendenceOrbitParallelMinGroups(
+	TEXT("RPG.Transcendence.OrbitParallelMinGroups"),
+	4,
+	TEXT("Minimum number of orbit groups computed in a step to spread them on the task graph workers, fewer groups are computed on the game thread. 0 never goes wide."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarRPGTranscendenceServerGameplayOnlyOrbit(
+	TEXT("RPG.Transcendence.ServerGameplayOnlyOrbit"),
+	1,
+	TEXT("On dedicated servers skip the per frame orbit simulation and solve the hammer fire window analytically, read when the world is created."),
+	ECVF_Default);
+
+/**Significance thresholds, meant to be overridden per platform in the device profiles*/
+static TAutoConsoleVariable<float> CVarRPGTranscendenceSignificanceMediumDistance(
+	TEXT("RPG.Transcendence.Significance.MediumDistance"),
+	2500.f,
+	TEXT("Distance from the closest local viewpoint where the hammers of a player drop to medium significance."),
+	ECVF_Scalability);
+
+static TAutoConsoleVariable<float> CVarRPGTranscendenceSignificanceLowDistance(
+	TEXT("RPG.Transcendence.Significance.LowDistance"),
+	6000.f,
+	TEXT("Distance from the closest local viewpoint where the hammers of a player drop to low significance, not rendered hammers beyond it are culled."),
+	ECVF_Scalability);
+
+static TAutoConsoleVariable<int32> CVarRPGTranscendenceSignificanceMediumInterval(
+	TEXT("RPG.Transcendence.Significance.MediumInterval"),
+	2,
+	TEXT("Orbit steps between two updates of the medium significance hammers."),
+	ECVF_Scalability);
+
+static TAutoConsoleVariable<int32> CVarRPGTranscendenceSignificanceLowInterval(
+	TEXT("RPG.Transcendence.Significance.LowInterval"),
+	4,
+	TEXT("Orbit steps between two updates of the low significance hammers."),
+	ECVF_Scalability);
+
+static TAutoConsoleVariable<int32> CVarRPGTranscendenceSignificanceCulledInterval(
+	TEXT("RPG.Transcendence.Significance.CulledInterval"),
+	8,
+	TEXT("Orbit steps between two updates of the culled hammers."),
+	ECVF_Scalability);
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	bIsGameplayOnlyOrbit = IsRunningDedicatedServer() && CVarRPGTranscendenceServerGameplayOnlyOrbit.GetValueOnGameThread() != 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::Tick(float DeltaTime)
+{
+	RPG_TRANSCENDENCE_SCOPE(STAT_RPGTranscendence_HammersOrbitMovement);
+
+	StepHammers(DeltaTime);
+
+	if (bIsGameplayOnlyOrbit)
+	{
+		ProcessAnalyticSpinningEvents();
+		FlushSpinningChecks();
+		return;
+	}
+
+	UpdateSignificance();
+
+	const float FixedStepSeconds = GetFixedStepSeconds();
+	if (FixedStepSeconds <= 0.f)
+	{
+		SimulateOrbitStep(DeltaTime);
+		CommitOrbitPositions(1.f, 0.f);
+	}
+	else
+	{
+		//The simulation always advances in fixed steps, the cost and the result do not depend on the frame rate
+		SimulationTimeAccumulator += DeltaTime;
+		int32 NumSimulatedSteps = 0;
+		while (SimulationTimeAccumulator >= FixedStepSeconds && NumSimulatedSteps < CVarRPGTranscendenceOrbitMaxStepsPerFrame.GetValueOnGameThread())
+		{
+			SimulateOrbitStep(FixedStepSeconds);
+			SimulationTimeAccumulator -= FixedStepSeconds;
+			NumSimulatedSteps++;
+		}
+
+		//Drop the time that could not be simulated this frame instead of spiraling on long frames
+		SimulationTimeAccumulator = FMath::Min(SimulationTimeAccumulator, FixedStepSeconds);
+
+		//Display the hammers between the last two simulated steps
+		CommitOrbitPositions(SimulationTimeAccumulator / FixedStepSeconds, SimulationTimeAccumulator);
+	}
+
+	FlushSpinningChecks();
+
+	SET_DWORD_STAT(STAT_RPGTranscendence_ActiveHammers, NumActiveHammers);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+float URPGTranscendenceHammerSubsystem::GetFixedStepSeconds() const
+{
+	const float FixedRateHz = CVarRPGTranscendenceOrbitFixedHz.GetValueOnGameThread();
+	return FixedRateHz > 0.f ? 1.f / FixedRateHz : 0.f;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+float URPGTranscendenceHammerSubsystem::GetSimulationStepSeconds() const
+{
+	const float FixedStepSeconds = GetFixedStepSeconds();
+	return FixedStepSeconds > 0.f ? FixedStepSeconds : GetWorld()->GetDeltaSeconds();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::SimulateOrbitStep(const float StepSeconds)
+{
+	//Prepare: decide which groups advance this step and read the actors they depend on
+	ComputeGroupIndices.Reset();
+	for (int32 GroupIndex = 0; GroupIndex < OrbitGroups.Num(); GroupIndex++)
+	{
+		FRPGHammerOrbitGroup& OrbitGroup = OrbitGroups[GroupIndex];
+		float GroupStepSeconds = 0.f;
+		int32 GroupStepCount = 0;
+		if (OrbitGroup.Significance == ERPGHammerSignificance::High)
+		{
+			GroupStepSeconds = StepSeconds;
+			GroupStepCount = 1;
+		}
+		else
+		{
+			//Reduced rate groups advance all the skipped steps at once
+			OrbitGroup.PendingStepSeconds += StepSeconds;
+			OrbitGroup.PendingStepCount++;
+			OrbitGroup.StepsUntilUpdate--;
+			if (OrbitGroup.StepsUntilUpdate <= 0)
+			{
+				GroupStepSeconds = OrbitGroup.PendingStepSeconds;
+				GroupStepCount = OrbitGroup.PendingStepCount;
+				OrbitGroup.PendingStepSeconds = 0.f;
+				OrbitGroup.PendingStepCount = 0;
+				OrbitGroup.StepsUntilUpdate = GetSignificanceStepInterval(OrbitGroup.Significance);
+			}
+		}
+
+		if (GroupStepSeconds <= 0.f)
+		{
+			continue;
+		}
+
+		OrbitGroup.bSimulatedSinceCommit = true;
+		if (PrepareOrbitGroup(OrbitGroup, GroupStepSeconds, GroupStepCount))
+		{
+			ComputeGroupIndices.Add(GroupIndex);
+		}
+	}
+
+	//Compute: the groups do not share any data, each one is a task graph work item
+	const int32 ParallelMinGroups = CVarRPGTranscendenceOrbitParallelMinGroups.GetValueOnGameThread();
+	const bool bForceSingleThread = ParallelMinGroups <= 0 || ComputeGroupIndices.Num() < ParallelMinGroups;
+	ParallelFor(ComputeGroupIndices.Num(), [this](const int32 ComputeIndex)
+	{
+		ComputeOrbitGroup(OrbitGroups[ComputeGroupIndices[ComputeIndex]]);
+	}, bForceSingleThread);
+
+	//Commit: back on the game thread in group order, the result does not depend on the worker scheduling
+	for (const int32 GroupIndex : ComputeGroupIndices)
+	{
+		CommitComputedOrbitGroup(OrbitGroups[GroupIndex]);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::UpdateSignificance()
+{
+	//Viewpoints of the local players, a dedicated server has none and keeps every group at full rate
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+	for (FConstPlayerControllerIterator PlayerControllerIterator = GetWorld()->GetPlayerControllerIterator(); PlayerControllerIterator; ++PlayerControllerIterator)
+	{
+		const APlayerController* PlayerController = PlayerControllerIterator->Get();
+		if (IsValid(PlayerController) && PlayerController->IsLocalController())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ViewLocations.Add(ViewLocation);
+		}
+	}
+
+	int32 NumHammersPerTier[4] = { 0, 0, 0, 0 };
+	for (FRPGHammerOrbitGroup& OrbitGroup : OrbitGroups)
+	{
+		const ERPGHammerSignificance NewSignificance = ComputeGroupSignificance(OrbitGroup, ViewLocations);
+		if (NewSignificance != OrbitGroup.Significance)
+		{
+			//A group promoted to full rate catches up on its next step, a demoted one waits for its new interval
+			OrbitGroup.StepsUntilUpdate = NewSignificance == ERPGHammerSignificance::High ? 0 : FMath::Min(OrbitGroup.StepsUntilUpdate, GetSignificanceStepInterval(NewSignificance));
+			if (NewSignificance == ERPGHammerSignificance::High && OrbitGroup.PendingStepSeconds > 0.f)
+			{
+				TickOrbitGroup(OrbitGroup, OrbitGroup.PendingStepSeconds, OrbitGroup.PendingStepCount);
+				OrbitGroup.PendingStepSeconds = 0.f;
+				OrbitGroup.PendingStepCount = 0;
+			}
+			OrbitGroup.Significance = NewSignificance;
+		}
+
+		NumHammersPerTier[static_cast<uint8>(OrbitGroup.Significance)] += OrbitGroup.NumActiveHammers;
+	}
+
+	SET_DWORD_STAT(STAT_RPGTranscendence_HighSignificanceHammers, NumHammersPerTier[0]);
+	SET_DWORD_STAT(STAT_RPGTranscendence_MediumSignificanceHammers, NumHammersPerTier[1]);
+	SET_DWORD_STAT(STAT_RPGTranscendence_LowSignificanceHammers, NumHammersPerTier[2]);
+	SET_DWORD_STAT(STAT_RPGTranscendence_CulledSignificanceHammers, NumHammersPerTier[3]);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+ERPGHammerSignificance URPGTranscendenceHammerSubsystem::ComputeGroupSignificance(const FRPGHammerOrbitGroup& OrbitGroup, const TArray<FVector, TInlineAllocator<4>>& ViewLocations) const
+{
+	const ARPGCharacterBase* OwnerCharacter = OrbitGroup.OwnerCharacter;
+	if (ViewLocations.Num() == 0 || !IsValid(OwnerCharacter) || OwnerCharacter->IsLocallyControlled())
+	{
+		return ERPGHammerSignificance::High;
+	}
+
+	//The fire window of a spinning hammer is only a few degrees wide, it has to be checked on every step
+	for (const FRPGHammerOrbitState& OrbitState : OrbitGroup.States)
+	{
+		if (OrbitState.IsActive() && OrbitState.bIsInSpinningMode)
+		{
+			return ERPGHammerSignificance::High;
+		}
+	}
+
+	const FVector OwnerLocation = OwnerCharacter->GetActorLocation();
+	float ClosestDistanceSquared = MAX_FLT;
+	for (const FVector& ViewLocation : ViewLocations)
+	{
+		ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, FVector::DistSquared(ViewLocation, OwnerLocation));
+	}
+
+	const bool bIsRendered = OwnerCharacter->WasRecentlyRendered(0.2f);
+	const float MediumDistance = CVarRPGTranscendenceSignificanceMediumDistance.GetValueOnGameThread();
+	const float LowDistance = CVarRPGTranscendenceSignificanceLowDistance.GetValueOnGameThread();
+	if (ClosestDistanceSquared > FMath::Square(LowDistance))
+	{
+		return bIsRendered ? ERPGHammerSignificance::Low : ERPGHammerSignificance::Culled;
+	}
+
+	if (!bIsRendered)
+	{
+		return ERPGHammerSignificance::Low;
+	}
+
+	return ClosestDistanceSquared > FMath::Square(MediumDistance) ? ERPGHammerSignificance::Medium : ERPGHammerSignificance::High;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+int32 URPGTranscendenceHammerSubsystem::GetSignificanceStepInterval(const ERPGHammerSignificance Significance)
+{
+	switch (Significance)
+	{
+	case ERPGHammerSignificance::Medium:
+		return FMath::Max(CVarRPGTranscendenceSignificanceMediumInterval.GetValueOnGameThread(), 1);
+	case ERPGHammerSignificance::Low:
+		return FMath::Max(CVarRPGTranscendenceSignificanceLowInterval.GetValueOnGameThread(), 1);
+	case ERPGHammerSignificance::Culled:
+		return FMath::Max(CVarRPGTranscendenceSignificanceCulledInterval.GetValueOnGameThread(), 1);
+	default:
+		return 1;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+ERPGHammerSignificance URPGTranscendenceHammerSubsystem::GetOwnerSignificance(const ARPGCharacterBase* OwnerCharacter) const
+{
+	const int32* GroupIndex = OrbitGroupIndexByOwner.Find(OwnerCharacter);
+	return GroupIndex ? OrbitGroups[*GroupIndex].Significance : ERPGHammerSignificance::High;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+FVector URPGTranscendenceHammerSubsystem::GetDisplayOffset(const FRPGHammerOrbitGroup& OrbitGroup, const FRPGHammerOrbitState& OrbitState, const float InterpolationAlpha, const float UnsimulatedSeconds)
+{
+	if (OrbitGroup.Significance == ERPGHammerSignificance::High)
+	{
+		return FMath::Lerp(OrbitState.PreviousOrbitOffset, OrbitState.OrbitOffset, InterpolationAlpha);
+	}
+
+	//Keep turning the last simulated offset with the last simulated speed until the next group update
+	const float ExtrapolatedSeconds = OrbitGroup.PendingStepSeconds + UnsimulatedSeconds;
+	const float ExtrapolatedAngle = OrbitState.RotationSpeed * OrbitState.RotationDirection * ExtrapolatedSeconds;
+	return OrbitState.OrbitOffset.RotateAngleAxis(ExtrapolatedAngle, OrbitState.GetTuning()->RotateAxisVector);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::CommitOrbitPositions(const float InterpolationAlpha, const float UnsimulatedSeconds)
+{
+	for (FRPGHammerOrbitGroup& OrbitGroup : OrbitGroups)
+	{
+		if (OrbitGroup.NumActiveHammers <= 0 || !IsValid(OrbitGroup.OwnerCharacter))
+		{
+			continue;
+		}
+
+		//Nobody sees the culled hammers, they are only moved when simulated
+		const bool bSimulatedSinceCommit = OrbitGroup.bSimulatedSinceCommit;
+		OrbitGroup.bSimulatedSinceCommit = false;
+		if (OrbitGroup.Significance == ERPGHammerSignificance::Culled && !bSimulatedSinceCommit)
+		{
+			continue;
+		}
+
+		FRPGTelemetryCycleScope TelemetryScope(OrbitGroup.GameThreadCycles);
+
+		//The offsets are relative to the owner so the hammers follow the player at display rate
+		const FVector OwnerLocation = OrbitGroup.OwnerCharacter->GetActorLocation();
+
+		//Orbiting hammers have no collision, a teleport without sweep moves them without any overlap or physics work
+		for (const FRPGHammerOrbitState& OrbitState : OrbitGroup.States)
+		{
+			if (OrbitState.IsActive() && IsValid(OrbitState.Hammer) && !OrbitState.bIsAttachedToRig)
+			{
+				const FVector DisplayOffset = GetDisplayOffset(OrbitGroup, OrbitState, InterpolationAlpha, UnsimulatedSeconds);
+				OrbitState.Hammer->SetActorLocation(OwnerLocation + DisplayOffset, false, nullptr, ETeleportType::TeleportPhysics);
+			}
+		}
+
+		if (IsValid(OrbitGroup.OrbitRig))
+		{
+			CommitRigTransforms(OrbitGroup, InterpolationAlpha, UnsimulatedSeconds);
+		}
+
+		if (IsValid(OrbitGroup.InstancedMesh))
+		{
+			CommitInstanceTransforms(OrbitGroup, OwnerLocation, InterpolationAlpha, UnsimulatedSeconds);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::CommitRigTransforms(FRPGHammerOrbitGroup& OrbitGroup, const float InterpolationAlpha, const float UnsimulatedSeconds)
+{
+	//The rig turns with the phase of the formation and its scale is the formation radius, the slotted hammers keep a unit offset
+	const RPGHammerOrbitMath::TOrbitState<float, FVector>& Formation = OrbitGroup.Formation;
+	const FVector& RotateAxisVector = OrbitGroup.FormationTuning ? OrbitGroup.FormationTuning->RotateAxisVector : URPGHammerTuningDataAsset::GetDefaultTuning()->RotateAxisVector;
+	float FormationAngle = Formation.RotationAngleAxis;
+	float FormationRadius = Formation.RotationRadius;
+	if (OrbitGroup.Significance == ERPGHammerSignificance::High)
+	{
+		FormationAngle = OrbitGroup.PreviousFormationAngle + FMath::FindDeltaAngleDegrees(OrbitGroup.PreviousFormationAngle, Formation.RotationAngleAxis) * InterpolationAlpha;
+		FormationRadius = FMath::Lerp(OrbitGroup.PreviousFormationRadius, Formation.RotationRadius, InterpolationAlpha);
+	}
+	else
+	{
+		FormationAngle += Formation.RotationSpeed * Formation.RotationDirection * (OrbitGroup.PendingStepSeconds + UnsimulatedSeconds);
+	}
+
+	const FQuat RigRotation(RotateAxisVector, FMath::DegreesToRadians(FormationAngle));
+	const float RigScale = FMath::Max(FormationRadius, 1.f);
+
+	//Only the hammers outside their slot and the ones that just took it get a new offset, it is applied by the rig update below
+	for (FRPGHammerOrbitState& OrbitState : OrbitGroup.States)
+	{
+		if (!OrbitState.bIsAttachedToRig || !IsValid(OrbitState.Hammer))
+		{
+			continue;
+		}
+
+		if (!OrbitState.bIsInRigSlot)
+		{
+			const FVector DisplayOffset = GetDisplayOffset(OrbitGroup, OrbitState, InterpolationAlpha, UnsimulatedSeconds);
+			OrbitGroup.OrbitRig->SetHammerRigOffset(OrbitState.Hammer, RigRotation.UnrotateVector(DisplayOffset) / RigScale);
+		}
+		else if (OrbitState.bHasToPlaceInRigSlot)
+		{
+			OrbitGroup.OrbitRig->SetHammerRigOffset(OrbitState.Hammer, RPGHammerOrbitMath::OrbitOffsetAboutAxis(1.f, OrbitState.RigSlotAngle, RotateAxisVector));
+			OrbitState.bHasToPlaceInRigSlot = false;
+		}
+	}
+
+	OrbitGroup.OrbitRig->SetFormationTransform(RigRotation, RigScale);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::CommitInstanceTransforms(FRPGHammerOrbitGroup& OrbitGroup, const FVector& OwnerLocation, const float InterpolationAlpha, const float UnsimulatedSeconds)
+{
+	const int32 NumInstances = OrbitGroup.InstancedMesh->GetInstanceCount();
+	if (NumInstances <= 0)
+	{
+		return;
+	}
+
+	//Slots without instance state (used or not registered) stay collapsed
+	const FQuat OwnerRotation = OrbitGroup.OwnerCharacter->GetActorQuat();
+	InstanceTransforms.Reset(NumInstances);
+	InstanceTransforms.Init(FTransform(OwnerRotation, OwnerLocation, FVector::ZeroVector), NumInstances);
+
+	const int32 NumStates = FMath::Min(NumInstances, OrbitGroup.States.Num());
+	for (int32 StateIndex = 0; StateIndex < NumStates; StateIndex++)
+	{
+		const FRPGHammerOrbitState& OrbitState = OrbitGroup.States[StateIndex];
+		if (OrbitState.bIsInstance)
+		{
+			const FVector DisplayOffset = GetDisplayOffset(OrbitGroup, OrbitState, InterpolationAlpha, UnsimulatedSeconds);
+			InstanceTransforms[StateIndex] = FTransform(OwnerRotation, OwnerLocation + DisplayOffset);
+		}
+	}
+
+	//One render state update for all the orbiting hammers of the player
+	OrbitGroup.InstancedMesh->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::FlushSpinningChecks()
+{
+	//Executed after the simulation because using a hammer can unregister hammers or end the ability
+	TArray<FRPGPendingSpinningCheck> SpinningChecksToRun = MoveTemp(PendingSpinningChecks);
+	PendingSpinningChecks.Reset();
+
+	for (const FRPGPendingSpinningCheck& SpinningCheck : SpinningChecksToRun)
+	{
+		ARPGTranscendenceHammer* Hammer = SpinningCheck.Hammer.Get();
+		if (IsValid(Hammer))
+		{
+			const AActor* HammerOwner = Hammer->GetOwner();
+			const uint64 CheckStartCycles = FPlatformTime::Cycles64();
+			Hammer->CheckSpinningModeState(SpinningCheck.bIsInFireWindow);
+			AddOwnerGameThreadCycles(HammerOwner, FPlatformTime::Cycles64() - CheckStartCycles);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::StepHammers(const float DeltaTime)
+{
+	if (SteppedHammers.Num() == 0)
+	{
+		HammerStepTimeAccumulator = 0.f;
+		return;
+	}
+
+	//Same step as the orbit, one step per frame when the orbit is simulated with the frame delta
+	const float StepSeconds = GetSimulationStepSeconds();
+	HammerStepTimeAccumulator += DeltaTime;
+	int32 NumSteps = 0;
+	while (HammerStepTimeAccumulator >= StepSeconds && NumSteps < CVarRPGTranscendenceOrbitMaxStepsPerFrame.GetValueOnGameThread())
+	{
+		//The last stepped hammer may have left during the previous step
+		if (SteppedHammers.Num() == 0)
+		{
+			HammerStepTimeAccumulator = 0.f;
+			break;
+		}
+
+		SteppedHammersToUpdate = SteppedHammers;
+		for (const TWeakObjectPtr<ARPGTranscendenceHammer>& SteppedHammer : SteppedHammersToUpdate)
+		{
+			ARPGTranscendenceHammer* Hammer = SteppedHammer.Get();
+			if (IsValid(Hammer))
+			{
+				const AActor* HammerOwner = Hammer->GetOwner();
+				const uint64 UpdateStartCycles = FPlatformTime::Cycles64();
+				Hammer->UpdateHammerState(StepSeconds);
+				AddOwnerGameThreadCycles(HammerOwner, FPlatformTime::Cycles64() - UpdateStartCycles);
+			}
+		}
+
+		HammerStepTimeAccumulator -= StepSeconds;
+		NumSteps++;
+	}
+
+	HammerStepTimeAccumulator = FMath::Min(HammerStepTimeAccumulator, StepSeconds);
+
+	SteppedHammers.RemoveAllSwap([](const TWeakObjectPtr<ARPGTranscendenceHammer>& SteppedHammer) { return !SteppedHammer.IsValid(); });
+	SET_DWORD_STAT(STAT_RPGTranscendence_SteppedHammers, SteppedHammers.Num());
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::AddSteppedHammer(ARPGTranscendenceHammer* Hammer)
+{
+	if (IsValid(Hammer))
+	{
+		SteppedHammers.AddUnique(Hammer);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::RemoveSteppedHammer(ARPGTranscendenceHammer* Hammer)
+{
+	SteppedHammers.RemoveSingleSwap(Hammer);
+	SET_DWORD_STAT(STAT_RPGTranscendence_SteppedHammers, SteppedHammers.Num());
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+ETickableTickType URPGTranscendenceHammerSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGTranscendenceHammerSubsystem::IsTickable() const
+{
+	//Idle orbiting hammers cost nothing in gameplay only mode, only the spinning ones wait for their check
+	const bool bHasOrbitWork = bIsGameplayOnlyOrbit ? AnalyticSpinningEvents.Num() > 0 : NumActiveHammers > 0;
+
+	//The hammers moving to an enemy already left the orbit and keep the subsystem ticking on their own
+	return bHasOrbitWork || SteppedHammers.Num() > 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+TStatId URPGTranscendenceHammerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(URPGTranscendenceHammerSubsystem, STATGROUP_Tickables);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::RegisterOrbitOwner(ARPGCharacterBase* OwnerCharacter, const int32 ExpectedNumberOfHammers)
+{
+	if (!IsValid(OwnerCharacter))
+	{
+		return;
+	}
+
+	FRPGHammerOrbitGroup* OrbitGroup = FindOrbitGroup(OwnerCharacter);
+	if (!OrbitGroup)
+	{
+		const int32 NewGroupIndex = OrbitGroups.AddDefaulted();
+		OrbitGroupIndexByOwner.Add(OwnerCharacter, NewGroupIndex);
+		OrbitGroup = &OrbitGroups[NewGroupIndex];
+		OrbitGroup->OwnerCharacter = OwnerCharacter;
+	}
+
+	//Every registration starts the telemetry of a new activation
+	OrbitGroup->GameThreadCycles.Reset();
+	OrbitGroup->PeakActiveHammers = OrbitGroup->NumActiveHammers;
+
+	OrbitGroup->States.Reserve(ExpectedNumberOfHammers);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::UnregisterOrbitOwner(ARPGCharacterBase* OwnerCharacter)
+{
+	int32 GroupIndex = INDEX_NONE;
+	if (!OrbitGroupIndexByOwner.RemoveAndCopyValue(OwnerCharacter, GroupIndex))
+	{
+		return;
+	}
+
+	//Hammers still on the rig are left where they are
+	FRPGHammerOrbitGroup& RemovedGroup = OrbitGroups[GroupIndex];
+	for (const FRPGHammerOrbitState& OrbitState : RemovedGroup.States)
+	{
+		if (OrbitState.bIsAttachedToRig && IsValid(RemovedGroup.OrbitRig))
+		{
+			RemovedGroup.OrbitRig->DetachHammer(OrbitState.Hammer);
+		}
+	}
+
+	NumActiveHammers -= RemovedGroup.NumActiveHammers;
+	OrbitGroups.RemoveAtSwap(GroupIndex, 1, false);
+	SET_DWORD_STAT(STAT_RPGTranscendence_ActiveHammers, NumActiveHammers);
+
+	//Fix the index of the group moved into the removed slot
+	if (OrbitGroups.IsValidIndex(GroupIndex))
+	{
+		OrbitGroupIndexByOwner.Add(OrbitGroups[GroupIndex].OwnerCharacter, GroupIndex);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGTranscendenceHammerSubsystem::RegisterHammer(ARPGTranscendenceHammer* Hammer, ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, const FRPGHammerOrbitState& InitialState)
+{
+	if (!IsValid(Hammer) || !IsValid(OwnerCharacter) || HammerIndex < 0)
+	{
+		return false;
+	}
+
+	FRPGHammerOrbitState* OrbitState = ActivateOrbitSlot(OwnerCharacter, HammerIndex, InitialState);
+	OrbitState->Hammer = Hammer;
+
+	//The hammers on the rig follow the player and the formation with one hierarchical update per group
+	if (URPGHammerOrbitRigComponent::CanDriveHammer(Hammer))
+	{
+		FRPGHammerOrbitGroup* OrbitGroup = FindOrbitGroup(OwnerCharacter);
+		if (!IsValid(OrbitGroup->OrbitRig))
+		{
+			OrbitGroup->OrbitRig = URPGHammerOrbitRigComponent::FindOrAddOrbitRig(OwnerCharacter);
+		}
+
+		if (IsValid(OrbitGroup->OrbitRig))
+		{
+			OrbitGroup->OrbitRig->AttachHammer(Hammer);
+			OrbitState->bIsAttachedToRig = true;
+		}
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGTranscendenceHammerSubsystem::RegisterInstance(ARPGCharacterBase* OwnerCharacter, UInstancedStaticMeshComponent* InstancedMesh, const int32 HammerIndex, const FRPGHammerOrbitState& InitialState)
+{
+	if (!IsValid(InstancedMesh) || !IsValid(OwnerCharacter) || HammerIndex < 0)
+	{
+		return false;
+	}
+
+	FRPGHammerOrbitState* OrbitState = ActivateOrbitSlot(OwnerCharacter, HammerIndex, InitialState);
+	OrbitState->bIsInstance = true;
+	FindOrbitGroup(OwnerCharacter)->InstancedMesh = InstancedMesh;
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+FRPGHammerOrbitState* URPGTranscendenceHammerSubsystem::ActivateOrbitSlot(ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, const FRPGHammerOrbitState& InitialState)
+{
+	FRPGHammerOrbitGroup* OrbitGroup = FindOrbitGroup(OwnerCharacter);
+	if (!OrbitGroup)
+	{
+		RegisterOrbitOwner(OwnerCharacter, HammerIndex + 1);
+		OrbitGroup = FindOrbitGroup(OwnerCharacter);
+	}
+
+	if (OrbitGroup->States.Num() <= HammerIndex)
+	{
+		OrbitGroup->States.SetNum(HammerIndex + 1);
+	}
+
+	FRPGHammerOrbitState& OrbitState = OrbitGroup->States[HammerIndex];
+	if (!OrbitState.IsActive())
+	{
+		OrbitGroup->NumActiveHammers++;
+		OrbitGroup->PeakActiveHammers = FMath::Max(OrbitGroup->PeakActiveHammers, OrbitGroup->NumActiveHammers);
+		NumActiveHammers++;
+	}
+
+	OrbitState = InitialState;
+	OrbitState.Hammer = nullptr;
+	OrbitState.bIsInstance = false;
+	OrbitState.bIsAttachedToRig = false;
+	OrbitState.bIsInRigSlot = false;
+	OrbitState.bHasToPlaceInRigSlot = false;
+
+	//Start displaying the hammer where it already is in the orbit
+	OrbitState.OrbitOffset = RPGHammerOrbitMath::OrbitOffsetAboutAxis(OrbitState.RotationRadius, OrbitState.RotationAngleAxis, OrbitState.GetTuning()->RotateAxisVector);
+	OrbitState.PreviousOrbitOffset = OrbitState.OrbitOffset;
+	OrbitState.AnalyticTime = GetWorld()->GetTimeSeconds();
+	return &OrbitState;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGTranscendenceHammerSubsystem::UnregisterHammer(const ARPGTranscendenceHammer* Hammer, const ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, FRPGHammerOrbitState* OutLastState)
+{
+	FRPGHammerOrbitGroup* OrbitGroup = FindOrbitGroup(OwnerCharacter);
+	const bool bValidSlot = OrbitGroup && OrbitGroup->States.IsValidIndex(HammerIndex) && OrbitGroup->States[HammerIndex].Hammer == Hammer;
+	if (!bValidSlot)
+	{
+		return false;
+	}
+
+	FRPGHammerOrbitState& OrbitState = OrbitGroup->States[HammerIndex];
+	if (bIsGameplayOnlyOrbit)
+	{
+		MaterializeOrbitAngle(OrbitState, GetWorld()->GetTimeSeconds());
+		CancelAnalyticSpinningEvent(OwnerCharacter, HammerIndex);
+	}
+
+	if (OutLastState)
+	{
+		*OutLastState = OrbitState;
+	}
+
+	//Used or deactivated hammers leave the rig where they are
+	if (OrbitState.bIsAttachedToRig && IsValid(OrbitGroup->OrbitRig))
+	{
+		OrbitGroup->OrbitRig->DetachHammer(OrbitState.Hammer);
+	}
+
+	OrbitState.Hammer = nullptr;
+	OrbitState.bIsAttachedToRig = false;
+	OrbitState.bIsInRigSlot = false;
+	OrbitGroup->NumActiveHammers--;
+	NumActiveHammers--;
+	SET_DWORD_STAT(STAT_RPGTranscendence_ActiveHammers, NumActiveHammers);
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGTranscendenceHammerSubsystem::UnregisterInstance(const ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, FRPGHammerOrbitState* OutLastState)
+{
+	FRPGHammerOrbitGroup* OrbitGroup = FindOrbitGroup(OwnerCharacter);
+	const bool bValidSlot = OrbitGroup && OrbitGroup->States.IsValidIndex(HammerIndex) && OrbitGroup->States[HammerIndex].bIsInstance;
+	if (!bValidSlot)
+	{
+		return false;
+	}
+
+	FRPGHammerOrbitState& OrbitState = OrbitGroup->States[HammerIndex];
+	if (bIsGameplayOnlyOrbit)
+	{
+		MaterializeOrbitAngle(OrbitState, GetWorld()->GetTimeSeconds());
+		CancelAnalyticSpinningEvent(OwnerCharacter, HammerIndex);
+	}
+
+	if (OutLastState)
+	{
+		*OutLastState = OrbitState;
+		OutLastState->bIsInstance = false;
+	}
+
+	OrbitState.bIsInstance = false;
+	OrbitGroup->NumActiveHammers--;
+	NumActiveHammers--;
+	SET_DWORD_STAT(STAT_RPGTranscendence_ActiveHammers, NumActiveHammers);
+
+	//Collapse the instance now, the group may not be committed again if it was the last one
+	if (IsValid(OrbitGroup->InstancedMesh) && HammerIndex < OrbitGroup->InstancedMesh->GetInstanceCount())
+	{
+		FTransform InstanceTransform;
+		OrbitGroup->InstancedMesh->GetInstanceTransform(HammerIndex, InstanceTransform, true);
+		InstanceTransform.SetScale3D(FVector::ZeroVector);
+		OrbitGroup->InstancedMesh->UpdateInstanceTransform(HammerIndex, InstanceTransform, true, true, true);
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::RestoreOrbitState(const ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, const FRPGHammerOrbitState& SimulatedState)
+{
+	FRPGHammerOrbitState* OrbitState = FindOrbitState(OwnerCharacter, HammerIndex);
+	if (!OrbitState)
+	{
+		return;
+	}
+
+	ARPGTranscendenceHammer* SlotHammer = OrbitState->Hammer;
+	const bool bSlotIsInstance = OrbitState->bIsInstance;
+	const bool bSlotIsAttachedToRig = OrbitState->bIsAttachedToRig;
+
+	*OrbitState = SimulatedState;
+	OrbitState->Hammer = SlotHammer;
+	OrbitState->bIsInstance = bSlotIsInstance;
+	OrbitState->bIsAttachedToRig = bSlotIsAttachedToRig;
+	OrbitState->bIsInRigSlot = false;
+	OrbitState->bHasToPlaceInRigSlot = false;
+	OrbitState->AnalyticTime = GetWorld()->GetTimeSeconds();
+
+	//A promoted spinning instance keeps waiting for its spinning check
+	if (bIsGameplayOnlyOrbit && OrbitState->bIsInSpinningMode && !OrbitState->bIsSpinningCheckQueued)
+	{
+		ScheduleAnalyticSpinningEvent(OwnerCharacter, HammerIndex, *OrbitState);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::StartOrbitSpinning(const ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, const bool bHasToUse, const float AngleOffset)
+{
+	FRPGHammerOrbitState* OrbitState = FindOrbitState(OwnerCharacter, HammerIndex);
+	if (!OrbitState)
+	{
+		return;
+	}
+
+	BeginOrbitSpinning(*OrbitState, bHasToUse, AngleOffset);
+
+	if (bIsGameplayOnlyOrbit)
+	{
+		ScheduleAnalyticSpinningEvent(OwnerCharacter, HammerIndex, *OrbitState);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::StopOrbitSpinning(const ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex)
+{
+	FRPGHammerOrbitState* OrbitState = FindOrbitState(OwnerCharacter, HammerIndex);
+	if (!OrbitState)
+	{
+		return;
+	}
+
+	EndOrbitSpinning(*OrbitState);
+
+	if (bIsGameplayOnlyOrbit)
+	{
+		CancelAnalyticSpinningEvent(OwnerCharacter, HammerIndex);
+
+		//Without the per step easing the orbit continues at the normal profile speed
+		RPGHammerOrbitMath::ContractedRotation(*OrbitState, OrbitState->GetActiveProfile());
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::BeginOrbitSpinning(FRPGHammerOrbitState& OrbitState, const bool bHasToUse, const float AngleOffset)
+{
+	OrbitState.RotationAngleAxis = OrbitState.RotationAngleAxis + AngleOffset;
+
+	//A rig hammer leaves its formation slot, its rig offset follows its own orbit until it settles again
+	OrbitState.bIsInRigSlot = false;
+	OrbitState.bHasToPlaceInRigSlot = false;
+
+	//The spinning profile of the tuning limits the orbit from now on, the state is checked on every simulation step after a small delay
+	OrbitState.bIsInSpinningMode = true;
+	OrbitState.bIsPreparingToUse = bHasToUse;
+	OrbitState.bIsSpinningCheckQueued = false;
+	OrbitState.SpinningCheckDelay = 0.20f;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::EndOrbitSpinning(FRPGHammerOrbitState& OrbitState)
+{
+	if (!OrbitState.bIsInSpinningMode)
+	{
+		return;
+	}
+
+	OrbitState.bIsInSpinningMode = false;
+	OrbitState.bIsPreparingToUse = false;
+	OrbitState.bIsSpinningCheckQueued = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::MaterializeOrbitAngle(FRPGHammerOrbitState& OrbitState, const double Time) const
+{
+	const float ElapsedSeconds = static_cast<float>(Time - OrbitState.AnalyticTime);
+	if (ElapsedSeconds > 0.f)
+	{
+		OrbitState.RotationAngleAxis = RPGHammerOrbitMath::AdvanceAngleAnalytic(OrbitState.RotationAngleAxis, OrbitState.RotationSpeed, OrbitState.RotationDirection, ElapsedSeconds);
+		OrbitState.AnalyticTime = Time;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::ScheduleAnalyticSpinningEvent(const ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, FRPGHammerOrbitState& OrbitState)
+{
+	CancelAnalyticSpinningEvent(OwnerCharacter, HammerIndex);
+
+	//The spinning speed is reached at once instead of eased step by step
+	RPGHammerOrbitMath::ContractedRotation(OrbitState, OrbitState.GetActiveProfile());
+
+	FRPGAnalyticSpinningEvent& SpinningEvent = AnalyticSpinningEvents.AddDefaulted_GetRef();
+	SpinningEvent.OwnerCharacter = OwnerCharacter;
+	SpinningEvent.HammerIndex = HammerIndex;
+	SpinningEvent.EventTime = OrbitState.AnalyticTime + OrbitState.SpinningCheckDelay;
+
+	//Hammers that are not used stop spinning as soon as the delay ends, the used ones when they first reach the fire window after it
+	if (OrbitState.bIsPreparingToUse && !OrbitState.bIsInstance)
+	{
+		const float AngleAfterDelay = RPGHammerOrbitMath::AdvanceAngleAnalytic(OrbitState.RotationAngleAxis, OrbitState.RotationSpeed, OrbitState.RotationDirection, OrbitState.SpinningCheckDelay);
+		const float SecondsToFireWindow = RPGHammerOrbitMath::SecondsToFireWindow(AngleAfterDelay, OrbitState.RotationSpeed, OrbitState.RotationDirection);
+		if (SecondsToFireWindow < 0.f)
+		{
+			//A still orbit never reaches the window, like the simulated one the hammer keeps waiting
+			AnalyticSpinningEvents.Pop(false);
+			return;
+		}
+		SpinningEvent.EventTime += SecondsToFireWindow;
+		SpinningEvent.EventAngleAxis = RPGHammerOrbitMath::AdvanceAngleAnalytic(AngleAfterDelay, OrbitState.RotationSpeed, OrbitState.RotationDirection, SecondsToFireWindow);
+		SpinningEvent.bIsInFireWindow = true;
+	}
+	else
+	{
+		//The analytic angle can lead the stepped one by one step of angle, the window is widened by that step
+		const float AngleAfterDelay = RPGHammerOrbitMath::AdvanceAngleAnalytic(OrbitState.RotationAngleAxis, OrbitState.RotationSpeed, OrbitState.RotationDirection, OrbitState.SpinningCheckDelay);
+		const float StepAngle = FMath::Abs(OrbitState.RotationSpeed) * GetSimulationStepSeconds();
+		SpinningEvent.EventAngleAxis = AngleAfterDelay;
+		SpinningEvent.bIsInFireWindow = RPGHammerOrbitMath::IsInFireWindow(AngleAfterDelay, StepAngle);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::CancelAnalyticSpinningEvent(const ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex)
+{
+	AnalyticSpinningEvents.RemoveAllSwap([OwnerCharacter, HammerIndex](const FRPGAnalyticSpinningEvent& SpinningEvent)
+	{
+		return SpinningEvent.HammerIndex == HammerIndex && SpinningEvent.OwnerCharacter == OwnerCharacter;
+	});
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::ProcessAnalyticSpinningEvents()
+{
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+	for (int32 EventIndex = AnalyticSpinningEvents.Num() - 1; EventIndex >= 0; EventIndex--)
+	{
+		const FRPGAnalyticSpinningEvent SpinningEvent = AnalyticSpinningEvents[EventIndex];
+		if (SpinningEvent.EventTime > CurrentTime)
+		{
+			continue;
+		}
+		AnalyticSpinningEvents.RemoveAtSwap(EventIndex, 1, false);
+
+		const ARPGCharacterBase* OwnerCharacter = SpinningEvent.OwnerCharacter.Get();
+		FRPGHammerOrbitGroup* OrbitGroup = FindOrbitGroup(OwnerCharacter);
+		if (!OrbitGroup || !OrbitGroup->States.IsValidIndex(SpinningEvent.HammerIndex) || !OrbitGroup->States[SpinningEvent.HammerIndex].IsActive())
+		{
+			continue;
+		}
+
+		//The check runs with the orbit as it was at the solved moment, not at the end of the frame, even if a query already materialized a later angle
+		FRPGHammerOrbitState& OrbitState = OrbitGroup->States[SpinningEvent.HammerIndex];
+		OrbitState.RotationAngleAxis = SpinningEvent.EventAngleAxis;
+		OrbitState.AnalyticTime = SpinningEvent.EventTime;
+
+		if (OrbitState.bIsInstance)
+		{
+			EndOrbitSpinning(OrbitState);
+			RPGHammerOrbitMath::ContractedRotation(OrbitState, OrbitState.GetActiveProfile());
+			continue;
+		}
+
+		//The only moment the server places the hammer: where the projectile or the control starts from
+		if (IsValid(OrbitState.Hammer) && IsValid(OrbitGroup->OwnerCharacter))
+		{
+			OrbitState.OrbitOffset = RPGHammerOrbitMath::OrbitOffsetAboutAxis(OrbitState.RotationRadius, OrbitState.RotationAngleAxis, OrbitState.GetTuning()->RotateAxisVector);
+			OrbitState.PreviousOrbitOffset = OrbitState.OrbitOffset;
+			OrbitState.Hammer->SetActorLocation(OrbitGroup->OwnerCharacter->GetActorLocation() + OrbitState.OrbitOffset, false, nullptr, ETeleportType::TeleportPhysics);
+
+			FRPGPendingSpinningCheck& SpinningCheck = PendingSpinningChecks.AddDefaulted_GetRef();
+			SpinningCheck.Hammer = OrbitState.Hammer;
+			SpinningCheck.bIsInFireWindow = SpinningEvent.bIsInFireWindow;
+			OrbitState.bIsSpinningCheckQueued = true;
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+FRPGHammerOrbitState* URPGTranscendenceHammerSubsystem::FindOrbitState(const ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex)
+{
+	FRPGHammerOrbitGroup* OrbitGroup = FindOrbitGroup(OwnerCharacter);
+	if (!OrbitGroup || !OrbitGroup->States.IsValidIndex(HammerIndex) || !OrbitGroup->States[HammerIndex].IsActive())
+	{
+		return nullptr;
+	}
+
+	FRPGHammerOrbitState& OrbitState = OrbitGroup->States[HammerIndex];
+	if (bIsGameplayOnlyOrbit)
+	{
+		MaterializeOrbitAngle(OrbitState, GetWorld()->GetTimeSeconds());
+	}
+	return &OrbitState;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+FRPGHammerOrbitGroup* URPGTranscendenceHammerSubsystem::FindOrbitGroup(const ARPGCharacterBase* OwnerCharacter)
+{
+	const int32* GroupIndex = OrbitGroupIndexByOwner.Find(OwnerCharacter);
+	return GroupIndex ? &OrbitGroups[*GroupIndex] : nullptr;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGTranscendenceHammerSubsystem::GetOrbitOwnerTelemetry(const ARPGCharacterBase* OwnerCharacter, int32& OutPeakActiveHammers, double& OutGameThreadMs) const
+{
+	const int32* GroupIndex = OrbitGroupIndexByOwner.Find(OwnerCharacter);
+	if (!GroupIndex)
+	{
+		return false;
+	}
+
+	const FRPGHammerOrbitGroup& OrbitGroup = OrbitGroups[*GroupIndex];
+	OutPeakActiveHammers = OrbitGroup.PeakActiveHammers;
+	OutGameThreadMs = OrbitGroup.GameThreadCycles.GetMilliseconds();
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::AddOwnerGameThreadCycles(const AActor* HammerOwner, const uint64 Cycles)
+{
+	FRPGHammerOrbitGroup* OrbitGroup = FindOrbitGroup(Cast<ARPGCharacterBase>(HammerOwner));
+	if (OrbitGroup)
+	{
+		OrbitGroup->GameThreadCycles.Cycles += Cycles;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::TickOrbitGroup(FRPGHammerOrbitGroup& OrbitGroup, const float DeltaSeconds, const int32 NumSteps)
+{
+	FRPGTelemetryCycleScope TelemetryScope(OrbitGroup.GameThreadCycles);
+
+	if (PrepareOrbitGroup(OrbitGroup, DeltaSeconds, NumSteps))
+	{
+		ComputeOrbitGroup(OrbitGroup);
+		CommitComputedOrbitGroup(OrbitGroup);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGTranscendenceHammerSubsystem::PrepareOrbitGroup(FRPGHammerOrbitGroup& OrbitGroup, const float DeltaSeconds, const int32 NumSteps)
+{
+	FRPGTelemetryCycleScope TelemetryScope(OrbitGroup.GameThreadCycles);
+
+	OrbitGroup.ComputeStepSeconds = 0.f;
+	OrbitGroup.ComputeStepCount = 0;
+	if (OrbitGroup.NumActiveHammers <= 0 || !IsValid(OrbitGroup.OwnerCharacter))
+	{
+		return false;
+	}
+
+	for (FRPGHammerOrbitState& OrbitState : OrbitGroup.States)
+	{
+		if (!OrbitState.IsActive())
+		{
+			continue;
+		}
+
+		const bool bHasValidDriver = OrbitState.bIsInstance ? IsValid(OrbitGroup.InstancedMesh) : IsValid(OrbitState.Hammer);
+		if (!bHasValidDriver)
+		{
+			OrbitState.Hammer = nullptr;
+			OrbitState.bIsInstance = false;
+			OrbitState.bIsAttachedToRig = false;
+			OrbitState.bIsInRigSlot = false;
+			OrbitGroup.NumActiveHammers--;
+			NumActiveHammers--;
+		}
+	}
+
+	//The owner transform is read once for the whole group instead of once per hammer
+	OrbitGroup.OwnerForwardVector = OrbitGroup.OwnerCharacter->GetActorForwardVector();
+	OrbitGroup.OwnerRightVector = OrbitGroup.OwnerCharacter->GetActorRightVector();
+	OrbitGroup.ComputeStepSeconds = DeltaSeconds;
+	OrbitGroup.ComputeStepCount = FMath::Max(NumSteps, 1);
+	OrbitGroup.ComputedSpinningChecks.Reset();
+	return OrbitGroup.NumActiveHammers > 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::ComputeOrbitGroup(FRPGHammerOrbitGroup& OrbitGroup)
+{
+	RPG_TRANSCENDENCE_SCOPE(STAT_RPGTranscendence_ComputeOrbitGroup);
+
+	const float DeltaSeconds = OrbitGroup.ComputeStepSeconds;
+	FRPGHammerOrbitBatchBuffers& Batch = OrbitGroup.Batch;
+	Batch.StateIndices.Reset();
+	Batch.Angles.Reset();
+	Batch.Speeds.Reset();
+	Batch.Directions.Reset();
+	Batch.Radii.Reset();
+	Batch.Axes.Reset();
+
+	//The formation the rig turns with is eased and advanced once for the whole group
+	bool bHasRigSlotHammers = false;
+	if (OrbitGroup.FormationTuning)
+	{
+		RPGHammerOrbitMath::TOrbitState<float, FVector>& Formation = OrbitGroup.Formation;
+		OrbitGroup.PreviousFormationAngle = Formation.RotationAngleAxis;
+		OrbitGroup.PreviousFormationRadius = Formation.RotationRadius;
+		RPGHammerOrbitMath::EaseOrbit(Formation, OrbitGroup.FormationTuning->GetProfile(false), OrbitGroup.OwnerForwardVector, OrbitGroup.OwnerRightVector, OrbitGroup.ComputeStepCount);
+		Formation.RotationAngleAxis = RPGHammerOrbitMath::AdvanceAngleAnalytic(Formation.RotationAngleAxis, Formation.RotationSpeed, Formation.RotationDirection, DeltaSeconds);
+		bHasRigSlotHammers = OrbitGroup.States.ContainsByPredicate([](const FRPGHammerOrbitState& OrbitState)
+		{
+			return OrbitState.bIsInRigSlot;
+		});
+	}
+
+	bool bAllRotateAboutZ = true;
+	for (int32 StateIndex = 0; StateIndex < OrbitGroup.States.Num(); StateIndex++)
+	{
+		FRPGHammerOrbitState& OrbitState = OrbitGroup.States[StateIndex];
+		if (!OrbitState.IsActive())
+		{
+			continue;
+		}
+
+		const URPGHammerTuningDataAsset* Tuning = OrbitState.GetTuning();
+		if (OrbitState.bIsInRigSlot)
+		{
+			//A slotted hammer eased exactly like the formation, it takes the eased values instead of easing again
+			OrbitState.RotationSpeed = OrbitGroup.Formation.RotationSpeed;
+			OrbitState.RotationDirection = OrbitGroup.Formation.RotationDirection;
+			OrbitState.RotationRadius = OrbitGroup.Formation.RotationRadius;
+			OrbitState.PreviewForwardVectorToCompare = OrbitGroup.Formation.PreviewForwardVectorToCompare;
+			OrbitState.CurrentDotAngleVariance = OrbitGroup.Formation.CurrentDotAngleVariance;
+		}
+		else
+		{
+			RPGHammerOrbitMath::EaseOrbit(OrbitState, Tuning->GetProfile(OrbitState.bIsInSpinningMode), OrbitGroup.OwnerForwardVector, OrbitGroup.OwnerRightVector, OrbitGroup.ComputeStepCount);
+		}
+
+		//Gather the orbit values of the group to advance all of them in one pass
+		Batch.StateIndices.Add(StateIndex);
+		Batch.Angles.Add(OrbitState.RotationAngleAxis);
+		Batch.Speeds.Add(OrbitState.RotationSpeed);
+		Batch.Directions.Add(OrbitState.RotationDirection);
+		Batch.Radii.Add(OrbitState.RotationRadius);
+		Batch.Axes.Add(Tuning->RotateAxisVector);
+		bAllRotateAboutZ &= Tuning->RotateAxisVector.Equals(FVector::UpVector);
+	}
+
+	FRPGHammerOrbitBatch OrbitBatch;
+	OrbitBatch.RotationAngleAxis = Batch.Angles.GetData();
+	OrbitBatch.RotationSpeed = Batch.Speeds.GetData();
+	OrbitBatch.RotationDirection = Batch.Directions.GetData();
+	OrbitBatch.RotationRadius = Batch.Radii.GetData();
+	OrbitBatch.RotateAxisVector = Batch.Axes.GetData();
+	OrbitBatch.Num = Batch.StateIndices.Num();
+	Batch.Positions.SetNumUninitialized(OrbitBatch.Num, false);
+
+	/*Calculate the new angle axis and offset of every hammer about the vector */
+	if (bAllRotateAboutZ)
+	{
+		RPGHammerOrbitKernel::AdvanceOrbitAroundZ(OrbitBatch, FVector::ZeroVector, DeltaSeconds, Batch.Positions.GetData());
+	}
+	else
+	{
+		RPGHammerOrbitKernel::AdvanceOrbitScalar(OrbitBatch, FVector::ZeroVector, DeltaSeconds, Batch.Positions.GetData());
+	}
+
+	for (int32 BatchIndex = 0; BatchIndex < OrbitBatch.Num; BatchIndex++)
+	{
+		FRPGHammerOrbitState& OrbitState = OrbitGroup.States[Batch.StateIndices[BatchIndex]];
+		OrbitState.RotationAngleAxis = Batch.Angles[BatchIndex];
+		OrbitState.PreviousOrbitOffset = OrbitState.OrbitOffset;
+		OrbitState.OrbitOffset = Batch.Positions[BatchIndex];
+
+		if (OrbitState.bIsInSpinningMode)
+		{
+			UpdateSpinningCheck(OrbitState, DeltaSeconds, OrbitGroup.ComputedSpinningChecks);
+		}
+		else if (OrbitState.bIsAttachedToRig)
+		{
+			UpdateRigSlot(OrbitGroup, OrbitState, DeltaSeconds, bHasRigSlotHammers);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::UpdateRigSlot(FRPGHammerOrbitGroup& OrbitGroup, FRPGHammerOrbitState& OrbitState, const float DeltaSeconds, bool& bHasRigSlotHammers)
+{
+	RPGHammerOrbitMath::TOrbitState<float, FVector>& Formation = OrbitGroup.Formation;
+	const FVector& RotateAxisVector = OrbitState.GetTuning()->RotateAxisVector;
+	if (OrbitState.bIsInRigSlot)
+	{
+		//The stepped angle drops the overshoot of a full turn, it is put back on the slot so the gameplay angle matches the displayed hammer
+		const float SlotDelta = FMath::FindDeltaAngleDegrees(OrbitState.RotationAngleAxis, Formation.RotationAngleAxis + OrbitState.RigSlotAngle);
+		if (!FMath::IsNearlyZero(SlotDelta, 0.01f))
+		{
+			OrbitState.RotationAngleAxis += SlotDelta;
+			OrbitState.OrbitOffset = RPGHammerOrbitMath::OrbitOffsetAboutAxis(OrbitState.RotationRadius, OrbitState.RotationAngleAxis, RotateAxisVector);
+		}
+		return;
+	}
+
+	//The first hammer seeds the formation, the others take their slot once their own easing reached the one of the formation
+	if (!bHasRigSlotHammers)
+	{
+		OrbitGroup.FormationTuning = OrbitState.GetTuning();
+		Formation.RotationSpeed = OrbitState.RotationSpeed;
+		Formation.RotationDirection = OrbitState.RotationDirection;
+		Formation.RotationRadius = OrbitState.RotationRadius;
+		Formation.PreviewForwardVectorToCompare = OrbitState.PreviewForwardVectorToCompare;
+		Formation.CurrentDotAngleVariance = OrbitState.CurrentDotAngleVariance;
+		Formation.bIsInSpinningMode = false;
+		OrbitGroup.PreviousFormationAngle = Formation.RotationAngleAxis - Formation.RotationSpeed * Formation.RotationDirection * DeltaSeconds;
+		OrbitGroup.PreviousFormationRadius = Formation.RotationRadius;
+	}
+	else
+	{
+		const float SlotTolerance = RPGHammerOrbitMath::TOrbitTuning<float>::RadiusStep * 0.5f;
+		const bool bMatchesFormation = OrbitState.GetTuning() == OrbitGroup.FormationTuning
+			&& OrbitState.RotationDirection == Formation.RotationDirection
+			&& FMath::IsNearlyEqual(OrbitState.RotationSpeed, Formation.RotationSpeed, SlotTolerance)
+			&& FMath::IsNearlyEqual(OrbitState.RotationRadius, Formation.RotationRadius, SlotTolerance);
+		if (!bMatchesFormation)
+		{
+			return;
+		}
+
+		OrbitState.RotationSpeed = Formation.RotationSpeed;
+		OrbitState.RotationRadius = Formation.RotationRadius;
+		OrbitState.OrbitOffset = RPGHammerOrbitMath::OrbitOffsetAboutAxis(OrbitState.RotationRadius, OrbitState.RotationAngleAxis, RotateAxisVector);
+	}
+
+	OrbitState.RigSlotAngle = FMath::FindDeltaAngleDegrees(Formation.RotationAngleAxis, OrbitState.RotationAngleAxis);
+	OrbitState.bIsInRigSlot = true;
+	OrbitState.bHasToPlaceInRigSlot = true;
+	bHasRigSlotHammers = true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::CommitComputedOrbitGroup(FRPGHammerOrbitGroup& OrbitGroup)
+{
+	PendingSpinningChecks.Append(OrbitGroup.ComputedSpinningChecks);
+	OrbitGroup.ComputedSpinningChecks.Reset();
+	OrbitGroup.ComputeStepSeconds = 0.f;
+	OrbitGroup.ComputeStepCount = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendenceHammerSubsystem::UpdateSpinningCheck(FRPGHammerOrbitState& OrbitState, const float DeltaSeconds, TArray<FRPGPendingSpinningCheck, TInlineAllocator<2>>& OutSpinningChecks)
+{
+	if (OrbitState.bIsSpinningCheckQueued)
+	{
+		return;
+	}
+
+	OrbitState.SpinningCheckDelay -= DeltaSeconds;
+	if (OrbitState.SpinningCheckDelay > 0.f)
+	{
+		return;
+	}
+
+	//Instances are never used, they only return to the normal orbit after the re-layout
+	if (OrbitState.bIsInstance)
+	{
+		EndOrbitSpinning(OrbitState);
+		return;
+	}
+
+	//The fire window is evaluated with the angle of this step, the hammer reacts once the simulation is done
+	const bool bIsInFireWindow = RPGHammerOrbitMath::IsInFireWindow(OrbitState.RotationAngleAxis);
+	if (!OrbitState.bIsPreparingToUse || bIsInFireWindow)
+	{
+		FRPGPendingSpinningCheck& SpinningCheck = OutSpinningChecks.AddDefaulted_GetRef();
+		SpinningCheck.Hammer = OrbitState.Hammer;
+		SpinningCheck.bIsInFireWindow = bIsInFireWindow;
+		OrbitState.bIsSpinningCheckQueued = true;
+	}
+}
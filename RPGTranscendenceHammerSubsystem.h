@@ -0,0 +1,401 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "SergioTestContentClasses/RPGHammerTuningDataAsset.h"
+#include "SergioTestContentClasses/RPGHammerOrbitMath.h"
+#include "SergioTestContentClasses/RPGTranscendenceTelemetry.h"
+#include "RPGTranscendenceHammerSubsystem.generated.h"
+
+class ARPGCharacterBase;
+class ARPGTranscendenceHammer;
+class UInstancedStaticMeshComponent;
+class URPGHammerOrbitRigComponent;
+
+/**Orbit state of a single hammer, owned by the subsystem and advanced in batch*/
+USTRUCT()
+struct FRPGHammerOrbitState
+{
+	GENERATED_BODY()
+
+	/**Hammer driven by this state, nullptr while the slot is not orbiting*/
+	UPROPERTY()
+	ARPGTranscendenceHammer* Hammer = nullptr;
+
+	/**Angle which the hammer rotates based on the player */
+	float RotationAngleAxis = 0.f;
+
+	/**Direction in which it rotates, -1 left or 1 right*/
+	float RotationDirection = -1.f;
+
+	/**The speed at which the hammer rotates*/
+	float RotationSpeed = 0.f;
+
+	/**The radius at which the hammer rotates */
+	float RotationRadius = 0.f;
+
+	/**Shared immutable tuning of the hammer, the limits and the axis are read from it*/
+	const URPGHammerTuningDataAsset* Tuning = nullptr;
+
+	/**Compare vector of the player's past forward position vs the current one*/
+	FVector PreviewForwardVectorToCompare = FVector::ZeroVector;
+
+	/**Variance Player Angle */
+	float CurrentDotAngleVariance = 0.f;
+
+	/**Offset from the owner at the last and the previous simulated steps, the display interpolates between them*/
+	FVector OrbitOffset = FVector::ZeroVector;
+	FVector PreviousOrbitOffset = FVector::ZeroVector;
+
+	/**Seconds of simulation left before the spinning state starts being checked*/
+	float SpinningCheckDelay = 0.f;
+
+	/**If it is true the hammer is rotanting in spinning mode*/
+	bool bIsInSpinningMode = false;
+
+	/**If it is true the spinning hammer has to be used once it reaches the fire window*/
+	bool bIsPreparingToUse = false;
+
+	/**The spinning check result is waiting to be delivered to the hammer*/
+	bool bIsSpinningCheckQueued = false;
+
+	/**Driven as an instance of the owner orbit instanced mesh instead of a hammer actor, the instance index is the hammer index*/
+	bool bIsInstance = false;
+
+	/**The hammer actor is a child of the owner orbit rig and is placed in rig space*/
+	bool bIsAttachedToRig = false;
+
+	/**The rig hammer orbits in its formation slot: it shares the orbit of the group formation and its rig offset does not change*/
+	bool bIsInRigSlot = false;
+
+	/**The rig hammer just took its formation slot, the next commit writes its slot offset once*/
+	bool bHasToPlaceInRigSlot = false;
+
+	/**Angle of the formation slot from the formation phase of the group*/
+	float RigSlotAngle = 0.f;
+
+	/**Gameplay only orbit: world time at which RotationAngleAxis was last brought up to date*/
+	double AnalyticTime = 0.0;
+
+	bool IsActive() const { return Hammer != nullptr || bIsInstance; }
+
+	const URPGHammerTuningDataAsset* GetTuning() const { return Tuning ? Tuning : URPGHammerTuningDataAsset::GetDefaultTuning(); }
+
+	/**Limits of the current mode, the spinning profile while spinning*/
+	const FRPGHammerOrbitProfile& GetActiveProfile() const { return GetTuning()->GetProfile(bIsInSpinningMode); }
+};
+
+/**How much the hammers of a player matter to the local viewers, lower tiers are simulated less often*/
+UENUM(BlueprintType)
+enum class ERPGHammerSignificance : uint8
+{
+	/**Close or owned by a local player, simulated every step*/
+	High,
+	/**Visible at mid distance, simulated at a reduced rate and extrapolated in between*/
+	Medium,
+	/**Visible far away or not rendered, simulated at a low rate and extrapolated in between*/
+	Low,
+	/**Not rendered and far away, simulated at the lowest rate and only moved when simulated*/
+	Culled
+};
+
+/**Spinning check result delivered to the hammer after the simulation*/
+struct FRPGPendingSpinningCheck
+{
+	TWeakObjectPtr<ARPGTranscendenceHammer> Hammer;
+
+	bool bIsInFireWindow = false;
+};
+
+/**Structure of arrays buffers of a group to run the batched orbit kernel, one per group so the groups can be computed on different workers*/
+struct FRPGHammerOrbitBatchBuffers
+{
+	TArray<int32> StateIndices;
+	TArray<float> Angles;
+	TArray<float> Speeds;
+	TArray<float> Directions;
+	TArray<float> Radii;
+	TArray<FVector> Axes;
+	TArray<FVector> Positions;
+};
+
+/**All the hammers orbiting the same player, indexed by the hammer index of the ability*/
+USTRUCT()
+struct FRPGHammerOrbitGroup
+{
+	GENERATED_BODY()
+
+	/**Player the hammers orbit around*/
+	UPROPERTY()
+	ARPGCharacterBase* OwnerCharacter = nullptr;
+
+	/**Contiguous orbit states, the array index is the hammer index*/
+	UPROPERTY()
+	TArray<FRPGHammerOrbitState> States;
+
+	/**Instanced mesh displaying the hammers that orbit without actor, nullptr when every hammer is an actor*/
+	UPROPERTY()
+	UInstancedStaticMeshComponent* InstancedMesh = nullptr;
+
+	/**Pivot on the owner carrying the hammer actors, turned once per commit*/
+	UPROPERTY()
+	URPGHammerOrbitRigComponent* OrbitRig = nullptr;
+
+	/**Group level orbit the rig turns and scales with, shared by the rig hammers in their formation slot. Seeded by the first hammer taking a slot*/
+	RPGHammerOrbitMath::TOrbitState<float, FVector> Formation;
+	const URPGHammerTuningDataAsset* FormationTuning = nullptr;
+
+	/**Formation phase and radius at the previous simulated step, the display interpolates between them*/
+	float PreviousFormationAngle = 0.f;
+	float PreviousFormationRadius = 0.f;
+
+	/**Number of states currently driving a hammer*/
+	int32 NumActiveHammers = 0;
+
+	/**Significance tier of the group, refreshed every frame from the distance and visibility of the owner*/
+	ERPGHammerSignificance Significance = ERPGHammerSignificance::High;
+
+	/**Simulation steps skipped by the reduced rate tiers that the next group update has to advance*/
+	float PendingStepSeconds = 0.f;
+
+	/**Number of simulation steps in PendingStepSeconds, the orbit eases once per step*/
+	int32 PendingStepCount = 0;
+
+	/**Steps left until the next update of a reduced rate group*/
+	int32 StepsUntilUpdate = 0;
+
+	/**The group was simulated since the last commit*/
+	bool bSimulatedSinceCommit = false;
+
+	/**Compute phase input gathered on the game thread: seconds to advance, 0 when the group is not computed this step*/
+	float ComputeStepSeconds = 0.f;
+
+	/**Compute phase input gathered on the game thread: simulation steps contained in ComputeStepSeconds*/
+	int32 ComputeStepCount = 0;
+
+	/**Compute phase input gathered on the game thread: owner orientation, the worker never reads the actor*/
+	FVector OwnerForwardVector = FVector::ForwardVector;
+	FVector OwnerRightVector = FVector::RightVector;
+
+	/**Compute phase output: spinning checks found by the worker, moved to the subsystem queue in the commit phase*/
+	TArray<FRPGPendingSpinningCheck, TInlineAllocator<2>> ComputedSpinningChecks;
+
+	/**Compute phase scratch*/
+	FRPGHammerOrbitBatchBuffers Batch;
+
+	/**Telemetry of the activation: game thread time spent on the hammers of the group and its most active hammers at once*/
+	FRPGTelemetryCycleCounter GameThreadCycles;
+	int32 PeakActiveHammers = 0;
+};
+
+/**Gameplay only orbit: moment a spinning state has its spinning check delivered*/
+struct FRPGAnalyticSpinningEvent
+{
+	TWeakObjectPtr<const ARPGCharacterBase> OwnerCharacter;
+
+	int32 HammerIndex = INDEX_NONE;
+
+	double EventTime = 0.0;
+
+	/**Orbit angle solved for EventTime, the state may already be materialized past that moment when the event is processed*/
+	float EventAngleAxis = 0.f;
+
+	bool bIsInFireWindow = false;
+};
+
+/**
+ * World level manager that owns the orbit state of every active transcendence hammer
+ * and advances all of them in a single tick instead of one looping timer per hammer.
+ * The orbit is simulated at a fixed rate (RPG.Transcendence.OrbitFixedHz) and interpolated for display.
+ * Every step is split in a game thread prepare phase, a compute phase that runs the groups in parallel on the task graph
+ * workers and a game thread commit phase that queues the hammer reactions.
+ * On a dedicated server (RPG.Transcendence.ServerGameplayOnlyOrbit) nothing is simulated per frame: the angles are
+ * functions of time, the fire window is solved analytically and the positions are only materialized when a hammer is used.
+ */
+UCLASS()
+class ACTIONRPG_API URPGTranscendenceHammerSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin USubsystem Interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	//~ End FTickableGameObject Interface
+
+	/**Create the orbit group of a player, called by the ability before spawning the hammers*/
+	void RegisterOrbitOwner(ARPGCharacterBase* OwnerCharacter, const int32 ExpectedNumberOfHammers);
+
+	/**Remove the orbit group of a player and stop driving all of its hammers*/
+	void UnregisterOrbitOwner(ARPGCharacterBase* OwnerCharacter);
+
+	/**Start driving the hammer orbit with the given initial state, returns false if it could not be registered*/
+	bool RegisterHammer(ARPGTranscendenceHammer* Hammer, ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, const FRPGHammerOrbitState& InitialState);
+
+	/**Stop driving the hammer orbit, OutLastState receives the last simulated values*/
+	bool UnregisterHammer(const ARPGTranscendenceHammer* Hammer, const ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, FRPGHammerOrbitState* OutLastState = nullptr);
+
+	/**Start driving the hammer index as an instance of the instanced mesh, without hammer actor*/
+	bool RegisterInstance(ARPGCharacterBase* OwnerCharacter, UInstancedStaticMeshComponent* InstancedMesh, const int32 HammerIndex, const FRPGHammerOrbitState& InitialState);
+
+	/**Stop driving and hide the instance, OutLastState receives the last simulated values*/
+	bool UnregisterInstance(const ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, FRPGHammerOrbitState* OutLastState = nullptr);
+
+	/**Continue the orbit of the hammer index from a previously simulated state, the slot keeps its current hammer*/
+	void RestoreOrbitState(const ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, const FRPGHammerOrbitState& SimulatedState);
+
+	/**Put the orbit of the hammer index in spinning mode moving it by AngleOffset, the spinning profile limits it until it stops*/
+	void StartOrbitSpinning(const ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, const bool bHasToUse, const float AngleOffset);
+
+	/**Return the orbit of the hammer index from spinning mode to its normal profile*/
+	void StopOrbitSpinning(const ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex);
+
+	/**Orbit state of the hammer, nullptr if the hammer is not orbiting. The angle is brought up to date in gameplay only mode*/
+	FRPGHammerOrbitState* FindOrbitState(const ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex);
+
+	UFUNCTION(BlueprintCallable)
+	int32 GetNumActiveHammers() const { return NumActiveHammers; }
+
+	/**Peak active hammers and game thread milliseconds spent on the hammers of the player since its orbit was registered, false if the player has no orbit group*/
+	bool GetOrbitOwnerTelemetry(const ARPGCharacterBase* OwnerCharacter, int32& OutPeakActiveHammers, double& OutGameThreadMs) const;
+
+	/**Significance tier of the hammers orbiting the player, High if the player has no orbit group*/
+	ERPGHammerSignificance GetOwnerSignificance(const ARPGCharacterBase* OwnerCharacter) const;
+
+	/**Seconds advanced by each orbit simulation step*/
+	float GetSimulationStepSeconds() const;
+
+	/**Nobody sees the orbit in this world, only the spinning checks are computed*/
+	bool IsGameplayOnlyOrbit() const { return bIsGameplayOnlyOrbit; }
+
+	/**Call UpdateHammerState of the hammer on every simulation step until it is removed, used by the states that are not part of the orbit*/
+	void AddSteppedHammer(ARPGTranscendenceHammer* Hammer);
+
+	/**Stop updating the hammer*/
+	void RemoveSteppedHammer(ARPGTranscendenceHammer* Hammer);
+
+protected:
+
+	/**Spinning mode changes of the state, shared by the simulated and the gameplay only orbit*/
+	static void BeginOrbitSpinning(FRPGHammerOrbitState& OrbitState, const bool bHasToUse, const float AngleOffset);
+	static void EndOrbitSpinning(FRPGHammerOrbitState& OrbitState);
+
+	/**Gameplay only orbit: bring the angle of the state to Time*/
+	void MaterializeOrbitAngle(FRPGHammerOrbitState& OrbitState, const double Time) const;
+
+	/**Gameplay only orbit: solve when the spinning check of the state has to run and queue it*/
+	void ScheduleAnalyticSpinningEvent(const ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, FRPGHammerOrbitState& OrbitState);
+
+	/**Gameplay only orbit: remove the pending spinning check of the hammer index*/
+	void CancelAnalyticSpinningEvent(const ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex);
+
+	/**Gameplay only orbit: run the spinning checks that are due, placing the hammers where the orbit is at that moment*/
+	void ProcessAnalyticSpinningEvents();
+
+	/**Fixed step length, 0 when the orbit is simulated with the frame delta*/
+	float GetFixedStepSeconds() const;
+
+	/**Advance the orbit of every group by one step, the reduced rate groups only when their interval is reached*/
+	void SimulateOrbitStep(const float StepSeconds);
+
+	/**Move the hammers to their interpolated display positions, UnsimulatedSeconds is the frame time not simulated yet*/
+	void CommitOrbitPositions(const float InterpolationAlpha, const float UnsimulatedSeconds);
+
+	/**Refresh the significance tier of every group from the local viewpoints*/
+	void UpdateSignificance();
+
+	/**Significance of the group seen from the viewpoints*/
+	ERPGHammerSignificance ComputeGroupSignificance(const FRPGHammerOrbitGroup& OrbitGroup, const TArray<FVector, TInlineAllocator<4>>& ViewLocations) const;
+
+	/**Steps between two updates of a group of the tier*/
+	static int32 GetSignificanceStepInterval(const ERPGHammerSignificance Significance);
+
+	/**Display offset of the state, interpolated for the full rate groups and extrapolated along the orbit for the reduced rate ones*/
+	static FVector GetDisplayOffset(const FRPGHammerOrbitGroup& OrbitGroup, const FRPGHammerOrbitState& OrbitState, const float InterpolationAlpha, const float UnsimulatedSeconds);
+
+	/**Deliver the spinning checks queued during the simulation*/
+	void FlushSpinningChecks();
+
+	/**Advance the stepped hammers by the fixed steps contained in the frame, in both orbit modes*/
+	void StepHammers(const float DeltaTime);
+
+	/**Advance every hammer orbiting the same player, the three phases run at once on the game thread*/
+	void TickOrbitGroup(FRPGHammerOrbitGroup& OrbitGroup, const float DeltaSeconds, const int32 NumSteps = 1);
+
+	/**Game thread: drop the hammers destroyed since the last step and gather everything the compute phase reads from actors*/
+	bool PrepareOrbitGroup(FRPGHammerOrbitGroup& OrbitGroup, const float DeltaSeconds, const int32 NumSteps);
+
+	/**Any thread: ease and advance the orbit of the group, only touches the group*/
+	static void ComputeOrbitGroup(FRPGHammerOrbitGroup& OrbitGroup);
+
+	/**Game thread: queue the spinning checks found by the compute phase*/
+	void CommitComputedOrbitGroup(FRPGHammerOrbitGroup& OrbitGroup);
+
+	/**Check when the spinning hammer is an acceptable angle to shoot smoothly forward case*/
+	static void UpdateSpinningCheck(FRPGHammerOrbitState& OrbitState, const float DeltaSeconds, TArray<FRPGPendingSpinningCheck, TInlineAllocator<2>>& OutSpinningChecks);
+
+	/**Compute phase: keep a slotted rig hammer on its slot, or give a settled rig hammer a slot in the formation*/
+	static void UpdateRigSlot(FRPGHammerOrbitGroup& OrbitGroup, FRPGHammerOrbitState& OrbitState, const float DeltaSeconds, bool& bHasRigSlotHammers);
+
+	FRPGHammerOrbitGroup* FindOrbitGroup(const ARPGCharacterBase* OwnerCharacter);
+
+	/**Telemetry of hammer reactions that can remove the group, the group is found again once they returned*/
+	void AddOwnerGameThreadCycles(const AActor* HammerOwner, const uint64 Cycles);
+
+	/**Activate the orbit slot of the hammer index with the initial state, shared by hammers and instances*/
+	FRPGHammerOrbitState* ActivateOrbitSlot(ARPGCharacterBase* OwnerCharacter, const int32 HammerIndex, const FRPGHammerOrbitState& InitialState);
+
+	/**Turn and scale the orbit rig of the group to the formation and place the hammers that left or just took their slot*/
+	void CommitRigTransforms(FRPGHammerOrbitGroup& OrbitGroup, const float InterpolationAlpha, const float UnsimulatedSeconds);
+
+	/**Move the instances of the group to their interpolated display transforms in a single batch*/
+	void CommitInstanceTransforms(FRPGHammerOrbitGroup& OrbitGroup, const FVector& OwnerLocation, const float InterpolationAlpha, const float UnsimulatedSeconds);
+
+	/**Orbit groups of all the players with active hammers*/
+	UPROPERTY()
+	TArray<FRPGHammerOrbitGroup> OrbitGroups;
+
+	/**Index of the orbit group of each player*/
+	TMap<const ARPGCharacterBase*, int32> OrbitGroupIndexByOwner;
+
+	/**Total number of hammers currently orbiting in this world*/
+	int32 NumActiveHammers = 0;
+
+	/**Frame time not yet consumed by the fixed step simulation*/
+	float SimulationTimeAccumulator = 0.f;
+
+	/**Spinning checks waiting for the end of the simulation*/
+	TArray<FRPGPendingSpinningCheck> PendingSpinningChecks;
+
+	/**Groups computed in the current step*/
+	TArray<int32> ComputeGroupIndices;
+
+	/**Scratch transforms sent to the instanced mesh of a group*/
+	TArray<FTransform> InstanceTransforms;
+
+	/**Hammers updated on every step outside of the orbit, the ones moving to an enemy*/
+	TArray<TWeakObjectPtr<ARPGTranscendenceHammer>> SteppedHammers;
+
+	/**Scratch copy of the stepped hammers, an update can leave the stepped states*/
+	TArray<TWeakObjectPtr<ARPGTranscendenceHammer>> SteppedHammersToUpdate;
+
+	/**Frame time not yet consumed by the stepped hammers*/
+	float HammerStepTimeAccumulator = 0.f;
+
+	/**Set at initialization on dedicated servers, see IsGameplayOnlyOrbit*/
+	bool bIsGameplayOnlyOrbit = false;
+
+	/**Gameplay only orbit: spinning checks waiting for their time, the only per frame work of that mode*/
+	TArray<FRPGAnalyticSpinningEvent> AnalyticSpinningEvents;
+};
@@ -0,0 +1,41 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SergioTestContentClasses/RPGTranscendenceHammer.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRPGTranscendenceHammerStateTransitionTest, "RPG.Transcendence.HammerStateTransitions",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRPGTranscendenceHammerStateTransitionTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumHammerStates = static_cast<int32>(ERPGTranscendenceHammerState::Controlling) + 1;
+
+	//Rows are the current state and columns the new state, both in enum order: Deactivated, Orbiting, Spinning, Projectile, MovingToEnemy, Controlling
+	const bool ExpectedTransitions[NumHammerStates][NumHammerStates] =
+	{
+		{ true, true,  false, false, false, false },
+		{ true, false, true,  false, false, false },
+		{ true, true,  false, true,  true,  false },
+		{ true, false, false, false, false, false },
+		{ true, false, false, false, false, true  },
+		{ true, false, false, false, false, false }
+	};
+
+	for (int32 FromIndex = 0; FromIndex < NumHammerStates; FromIndex++)
+	{
+		for (int32 ToIndex = 0; ToIndex < NumHammerStates; ToIndex++)
+		{
+			const ERPGTranscendenceHammerState FromState = static_cast<ERPGTranscendenceHammerState>(FromIndex);
+			const ERPGTranscendenceHammerState ToState = static_cast<ERPGTranscendenceHammerState>(ToIndex);
+			TestEqual(FString::Printf(TEXT("%s -> %s"), *UEnum::GetValueAsString(FromState), *UEnum::GetValueAsString(ToState)),
+				ARPGTranscendenceHammer::IsValidHammerStateTransition(FromState, ToState), ExpectedTransitions[FromIndex][ToIndex]);
+		}
+	}
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
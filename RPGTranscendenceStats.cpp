@@ -0,0 +1,45 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SergioTestContentClasses/RPGTranscendenceStats.h"
+#include "SergioTestContentClasses/RPGTranscendenceHammer.h"
+
+DEFINE_STAT(STAT_RPGTranscendence_HammersOrbitMovement);
+DEFINE_STAT(STAT_RPGTranscendence_CheckSpinningModeState);
+DEFINE_STAT(STAT_RPGTranscendence_MoveToEnemy);
+DEFINE_STAT(STAT_RPGTranscendence_SendHammerToControl);
+DEFINE_STAT(STAT_RPGTranscendence_UseHammer);
+DEFINE_STAT(STAT_RPGTranscendence_SpawnHammers);
+DEFINE_STAT(STAT_RPGTranscendence_ComputeOrbitGroup);
+DEFINE_STAT(STAT_RPGTranscendence_BudgetedHammerSpawns);
+DEFINE_STAT(STAT_RPGTranscendence_ActiveHammers);
+DEFINE_STAT(STAT_RPGTranscendence_SteppedHammers);
+DEFINE_STAT(STAT_RPGTranscendence_PendingHammerRequests);
+DEFINE_STAT(STAT_RPGTranscendence_HighSignificanceHammers);
+DEFINE_STAT(STAT_RPGTranscendence_MediumSignificanceHammers);
+DEFINE_STAT(STAT_RPGTranscendence_LowSignificanceHammers);
+DEFINE_STAT(STAT_RPGTranscendence_CulledSignificanceHammers);
+
+UE_TRACE_CHANNEL_DEFINE(TranscendenceChannel);
+
+UE_TRACE_EVENT_BEGIN(RPGTranscendence, HammerStateChange)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, HammerId)
+	UE_TRACE_EVENT_FIELD(uint32, OwnerId)
+	UE_TRACE_EVENT_FIELD(uint8, OldState)
+	UE_TRACE_EVENT_FIELD(uint8, NewState)
+UE_TRACE_EVENT_END()
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void RPGTranscendenceTrace::OutputHammerStateChange(const ARPGTranscendenceHammer* Hammer, const ERPGTranscendenceHammerState OldState, const ERPGTranscendenceHammerState NewState)
+{
+	const AActor* HammerOwner = Hammer->GetOwner();
+
+	UE_TRACE_LOG(RPGTranscendence, HammerStateChange, TranscendenceChannel)
+		<< HammerStateChange.Cycle(FPlatformTime::Cycles64())
+		<< HammerStateChange.HammerId(Hammer->GetUniqueID())
+		<< HammerStateChange.OwnerId(HammerOwner ? HammerOwner->GetUniqueID() : 0)
+		<< HammerStateChange.OldState(static_cast<uint8>(OldState))
+		<< HammerStateChange.NewState(static_cast<uint8>(NewState));
+}
@@ -0,0 +1,44 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+class ARPGTranscendenceHammer;
+enum class ERPGTranscendenceHammerState : uint8;
+
+DECLARE_STATS_GROUP(TEXT("RPG Transcendence"), STATGROUP_RPGTranscendence, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Hammers Orbit Movement"), STAT_RPGTranscendence_HammersOrbitMovement, STATGROUP_RPGTranscendence, ACTIONRPG_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Check Spinning Mode State"), STAT_RPGTranscendence_CheckSpinningModeState, STATGROUP_RPGTranscendence, ACTIONRPG_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Move To Enemy"), STAT_RPGTranscendence_MoveToEnemy, STATGROUP_RPGTranscendence, ACTIONRPG_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Send Hammer To Control"), STAT_RPGTranscendence_SendHammerToControl, STATGROUP_RPGTranscendence, ACTIONRPG_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Use Hammer"), STAT_RPGTranscendence_UseHammer, STATGROUP_RPGTranscendence, ACTIONRPG_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Activate Ability Spawn Hammers"), STAT_RPGTranscendence_SpawnHammers, STATGROUP_RPGTranscendence, ACTIONRPG_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Compute Orbit Group"), STAT_RPGTranscendence_ComputeOrbitGroup, STATGROUP_RPGTranscendence, ACTIONRPG_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Budgeted Hammer Spawns"), STAT_RPGTranscendence_BudgetedHammerSpawns, STATGROUP_RPGTranscendence, ACTIONRPG_API);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Active Hammers"), STAT_RPGTranscendence_ActiveHammers, STATGROUP_RPGTranscendence, ACTIONRPG_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Stepped Hammers"), STAT_RPGTranscendence_SteppedHammers, STATGROUP_RPGTranscendence, ACTIONRPG_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pending Hammer Requests"), STAT_RPGTranscendence_PendingHammerRequests, STATGROUP_RPGTranscendence, ACTIONRPG_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Hammers High Significance"), STAT_RPGTranscendence_HighSignificanceHammers, STATGROUP_RPGTranscendence, ACTIONRPG_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Hammers Medium Significance"), STAT_RPGTranscendence_MediumSignificanceHammers, STATGROUP_RPGTranscendence, ACTIONRPG_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Hammers Low Significance"), STAT_RPGTranscendence_LowSignificanceHammers, STATGROUP_RPGTranscendence, ACTIONRPG_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Hammers Culled Significance"), STAT_RPGTranscendence_CulledSignificanceHammers, STATGROUP_RPGTranscendence, ACTIONRPG_API);
+
+/**Trace channel of the transcendence ability, enable it with -trace=cpu,Transcendence*/
+UE_TRACE_CHANNEL_EXTERN(TranscendenceChannel, ACTIONRPG_API);
+
+/**Cycle stat and Insights CPU scope on the transcendence channel*/
+#define RPG_TRANSCENDENCE_SCOPE(StatName) \
+	SCOPE_CYCLE_COUNTER(StatName); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(StatName, TranscendenceChannel)
+
+namespace RPGTranscendenceTrace
+{
+	/**Trace event of a hammer moving between orbit, spinning, projectile/control and deactivated*/
+	ACTIONRPG_API void OutputHammerStateChange(const ARPGTranscendenceHammer* Hammer, const ERPGTranscendenceHammerState OldState, const ERPGTranscendenceHammerState NewState);
+}
@@ -0,0 +1,334 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SergioTestContentClasses/RPGTranscendenceTelemetry.h"
+#include "Containers/CircularQueue.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogRPGTranscendenceTelemetry, Log, All);
+
+static TAutoConsoleVariable<int32> CVarRPGTranscendenceTelemetry(
+	TEXT("RPG.Transcendence.Telemetry"),
+	1,
+	TEXT("Per activation records of the transcendence ability written to Saved/Telemetry. 0 off, 1 CSV, 2 JSON lines."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarRPGTranscendenceTelemetryMaxFileKB(
+	TEXT("RPG.Transcendence.TelemetryMaxFileKB"),
+	1024,
+	TEXT("Size in KB at which the transcendence telemetry file is rotated."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarRPGTranscendenceTelemetryMaxFiles(
+	TEXT("RPG.Transcendence.TelemetryMaxFiles"),
+	4,
+	TEXT("Rotated transcendence telemetry files kept next to the current one."),
+	ECVF_Default);
+
+/**Records the ring buffer can hold, more activations than this between two writer wake ups are dropped*/
+static constexpr uint32 TelemetryRingBufferSize = 256;
+
+/**Background writer of the activation records, the game thread is the only producer of its ring buffer*/
+class FRPGTranscendenceTelemetryWriter : public FRunnable
+{
+public:
+
+	FRPGTranscendenceTelemetryWriter();
+	virtual ~FRPGTranscendenceTelemetryWriter();
+
+	/**Game thread: copy the record into the ring buffer and wake the writer*/
+	void Submit(const FRPGTranscendenceActivationRecord& Record);
+
+	//~ Begin FRunnable Interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	//~ End FRunnable Interface
+
+private:
+
+	/**Writer thread: empty the ring buffer into the file of the current format*/
+	void WriteQueuedRecords();
+
+	/**Open the current file of the format in append mode, with the CSV header when the file is new*/
+	bool OpenFile(const int32 Format);
+
+	/**Close the current file and shift the rotated ones, the oldest one is deleted*/
+	void RotateFiles(const int32 Format);
+
+	/**Current file for RotationIndex 0, rotated files for the next indices*/
+	FString GetFilePath(const int32 Format, const int32 RotationIndex) const;
+
+	static FString FormatCsvRecord(const FRPGTranscendenceActivationRecord& Record);
+	static FString FormatJsonRecord(const FRPGTranscendenceActivationRecord& Record);
+
+	TCircularQueue<FRPGTranscendenceActivationRecord> RingBuffer;
+
+	/**Records lost because the ring buffer was full, reported by the writer*/
+	FThreadSafeCounter NumDroppedRecords;
+
+	FEvent* WakeEvent = nullptr;
+
+	/**nullptr on platforms without threads, the records are written when submitted*/
+	FRunnableThread* Thread = nullptr;
+
+	TAtomic<bool> bStopRequested;
+
+	/**Resolved on the game thread, the writer never queries the paths*/
+	FString TelemetryDirectory;
+
+	TUniquePtr<IFileHandle> FileHandle;
+
+	/**Format of the open file, 0 when no file is open*/
+	int32 OpenFormat = 0;
+};
+
+static TUniquePtr<FRPGTranscendenceTelemetryWriter> TelemetryWriter;
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+FRPGTranscendenceTelemetryWriter::FRPGTranscendenceTelemetryWriter()
+	: RingBuffer(TelemetryRingBufferSize)
+	, bStopRequested(false)
+{
+	TelemetryDirectory = FPaths::ProjectSavedDir() / TEXT("Telemetry");
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+
+	if (FPlatformProcess::SupportsMultithreading())
+	{
+		Thread = FRunnableThread::Create(this, TEXT("RPGTranscendenceTelemetry"), 0, TPri_Lowest);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+FRPGTranscendenceTelemetryWriter::~FRPGTranscendenceTelemetryWriter()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+	else
+	{
+		WriteQueuedRecords();
+	}
+
+	FileHandle.Reset();
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = nullptr;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void FRPGTranscendenceTelemetryWriter::Submit(const FRPGTranscendenceActivationRecord& Record)
+{
+	if (!RingBuffer.Enqueue(Record))
+	{
+		NumDroppedRecords.Increment();
+	}
+
+	if (Thread)
+	{
+		WakeEvent->Trigger();
+	}
+	else
+	{
+		WriteQueuedRecords();
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+uint32 FRPGTranscendenceTelemetryWriter::Run()
+{
+	while (!bStopRequested)
+	{
+		WakeEvent->Wait(1000);
+		WriteQueuedRecords();
+	}
+
+	//Records submitted while stopping
+	WriteQueuedRecords();
+	return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void FRPGTranscendenceTelemetryWriter::Stop()
+{
+	bStopRequested = true;
+	WakeEvent->Trigger();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void FRPGTranscendenceTelemetryWriter::WriteQueuedRecords()
+{
+	const int32 NumDropped = NumDroppedRecords.Set(0);
+	if (NumDropped > 0)
+	{
+		UE_LOG(LogRPGTranscendenceTelemetry, Warning, TEXT("%d transcendence activation records dropped, the telemetry ring buffer was full"), NumDropped);
+	}
+
+	const int32 Format = CVarRPGTranscendenceTelemetry.GetValueOnAnyThread();
+	bool bHasWritten = false;
+	FRPGTranscendenceActivationRecord Record;
+	while (RingBuffer.Dequeue(Record))
+	{
+		if (Format != OpenFormat && !OpenFile(Format))
+		{
+			continue;
+		}
+
+		const FString RecordLine = (Format == 2 ? FormatJsonRecord(Record) : FormatCsvRecord(Record)) + LINE_TERMINATOR;
+		const FTCHARToUTF8 RecordUtf8(*RecordLine);
+		FileHandle->Write(reinterpret_cast<const uint8*>(RecordUtf8.Get()), RecordUtf8.Length());
+		bHasWritten = true;
+
+		if (FileHandle->Size() >= CVarRPGTranscendenceTelemetryMaxFileKB.GetValueOnAnyThread() * 1024LL)
+		{
+			RotateFiles(Format);
+		}
+	}
+
+	if (bHasWritten && FileHandle)
+	{
+		FileHandle->Flush();
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool FRPGTranscendenceTelemetryWriter::OpenFile(const int32 Format)
+{
+	FileHandle.Reset();
+	OpenFormat = 0;
+	if (Format != 1 && Format != 2)
+	{
+		return false;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*TelemetryDirectory);
+
+	const FString FilePath = GetFilePath(Format, 0);
+	FileHandle.Reset(PlatformFile.OpenWrite(*FilePath, true, false));
+	if (!FileHandle)
+	{
+		UE_LOG(LogRPGTranscendenceTelemetry, Warning, TEXT("Could not open the transcendence telemetry file %s"), *FilePath);
+		return false;
+	}
+
+	if (Format == 1 && FileHandle->Size() == 0)
+	{
+		const FTCHARToUTF8 HeaderUtf8(TEXT("StartTime,Ability,Authority,DurationSeconds,HammersSpawned,TimeToFirstUseSeconds,FireUses,ControlUses,EnemiesControlled,GameThreadMs,PeakActiveHammers,EndReason") LINE_TERMINATOR);
+		FileHandle->Write(reinterpret_cast<const uint8*>(HeaderUtf8.Get()), HeaderUtf8.Length());
+	}
+
+	OpenFormat = Format;
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void FRPGTranscendenceTelemetryWriter::RotateFiles(const int32 Format)
+{
+	FileHandle.Reset();
+	OpenFormat = 0;
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const int32 MaxRotatedFiles = FMath::Max(CVarRPGTranscendenceTelemetryMaxFiles.GetValueOnAnyThread(), 0);
+	PlatformFile.DeleteFile(*GetFilePath(Format, MaxRotatedFiles));
+	for (int32 RotationIndex = MaxRotatedFiles - 1; RotationIndex >= 0; RotationIndex--)
+	{
+		const FString RotatedFilePath = GetFilePath(Format, RotationIndex);
+		if (PlatformFile.FileExists(*RotatedFilePath))
+		{
+			PlatformFile.MoveFile(*GetFilePath(Format, RotationIndex + 1), *RotatedFilePath);
+		}
+	}
+
+	//Without rotated files the current one starts again
+	PlatformFile.DeleteFile(*GetFilePath(Format, 0));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+FString FRPGTranscendenceTelemetryWriter::GetFilePath(const int32 Format, const int32 RotationIndex) const
+{
+	const TCHAR* Extension = Format == 2 ? TEXT("jsonl") : TEXT("csv");
+	const FString FileName = RotationIndex > 0 ? FString::Printf(TEXT("Transcendence.%d.%s"), RotationIndex, Extension) : FString::Printf(TEXT("Transcendence.%s"), Extension);
+	return TelemetryDirectory / FileName;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+FString FRPGTranscendenceTelemetryWriter::FormatCsvRecord(const FRPGTranscendenceActivationRecord& Record)
+{
+	return FString::Printf(TEXT("%s,%s,%d,%.3f,%d,%.3f,%d,%d,%d,%.3f,%d,%s"),
+		*Record.StartTime.ToIso8601(), *Record.AbilityClassName.ToString(), Record.bHasAuthority ? 1 : 0, Record.DurationSeconds, Record.NumHammersSpawned, Record.TimeToFirstUseSeconds,
+		Record.NumFireUses, Record.NumControlUses, Record.NumEnemiesControlled, Record.GameThreadMs, Record.PeakActiveHammers, RPGTranscendenceTelemetry::LexToString(Record.EndReason));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+FString FRPGTranscendenceTelemetryWriter::FormatJsonRecord(const FRPGTranscendenceActivationRecord& Record)
+{
+	return FString::Printf(TEXT("{\"StartTime\":\"%s\",\"Ability\":\"%s\",\"Authority\":%s,\"DurationSeconds\":%.3f,\"HammersSpawned\":%d,\"TimeToFirstUseSeconds\":%.3f,")
+		TEXT("\"FireUses\":%d,\"ControlUses\":%d,\"EnemiesControlled\":%d,\"GameThreadMs\":%.3f,\"PeakActiveHammers\":%d,\"EndReason\":\"%s\"}"),
+		*Record.StartTime.ToIso8601(), *Record.AbilityClassName.ToString(), Record.bHasAuthority ? TEXT("true") : TEXT("false"), Record.DurationSeconds, Record.NumHammersSpawned, Record.TimeToFirstUseSeconds,
+		Record.NumFireUses, Record.NumControlUses, Record.NumEnemiesControlled, Record.GameThreadMs, Record.PeakActiveHammers, RPGTranscendenceTelemetry::LexToString(Record.EndReason));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void RPGTranscendenceTelemetry::SubmitActivationRecord(const FRPGTranscendenceActivationRecord& Record)
+{
+	check(IsInGameThread());
+
+	if (CVarRPGTranscendenceTelemetry.GetValueOnGameThread() <= 0)
+	{
+		return;
+	}
+
+	if (!TelemetryWriter)
+	{
+		TelemetryWriter = MakeUnique<FRPGTranscendenceTelemetryWriter>();
+		FCoreDelegates::OnPreExit.AddStatic(&RPGTranscendenceTelemetry::Shutdown);
+	}
+
+	TelemetryWriter->Submit(Record);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void RPGTranscendenceTelemetry::Shutdown()
+{
+	TelemetryWriter.Reset();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+const TCHAR* RPGTranscendenceTelemetry::LexToString(const ERPGTranscendenceEndReason EndReason)
+{
+	switch (EndReason)
+	{
+	case ERPGTranscendenceEndReason::ManaOut:
+		return TEXT("ManaOut");
+	case ERPGTranscendenceEndReason::CancelTag:
+		return TEXT("CancelTag");
+	case ERPGTranscendenceEndReason::EffectRemoved:
+		return TEXT("EffectRemoved");
+	case ERPGTranscendenceEndReason::Cancelled:
+		return TEXT("Cancelled");
+	default:
+		return TEXT("Ended");
+	}
+}
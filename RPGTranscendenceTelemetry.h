@@ -0,0 +1,108 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+
+/**Why a transcendence activation ended*/
+enum class ERPGTranscendenceEndReason : uint8
+{
+	/**Ended by the ability itself or by a path without its own reason*/
+	Ended,
+	/**The mana drain emptied the mana*/
+	ManaOut,
+	/**The player sent the cancel tag*/
+	CancelTag,
+	/**The transcendence effect was removed from the player*/
+	EffectRemoved,
+	/**Cancelled from outside of the ability*/
+	Cancelled
+};
+
+/**Game thread cycles spent in hammer code, only the outermost of nested scopes is counted*/
+struct FRPGTelemetryCycleCounter
+{
+	uint64 Cycles = 0;
+
+	int32 ScopeDepth = 0;
+
+	void Reset() { Cycles = 0; }
+
+	double GetMilliseconds() const { return FPlatformTime::ToMilliseconds64(Cycles); }
+};
+
+/**Adds the cycles of the scope to the counter*/
+struct FRPGTelemetryCycleScope
+{
+	explicit FRPGTelemetryCycleScope(FRPGTelemetryCycleCounter& InCounter)
+		: Counter(InCounter)
+	{
+		if (Counter.ScopeDepth++ == 0)
+		{
+			StartCycles = FPlatformTime::Cycles64();
+		}
+	}
+
+	~FRPGTelemetryCycleScope()
+	{
+		if (--Counter.ScopeDepth == 0)
+		{
+			Counter.Cycles += FPlatformTime::Cycles64() - StartCycles;
+		}
+	}
+
+private:
+
+	FRPGTelemetryCycleCounter& Counter;
+
+	uint64 StartCycles = 0;
+};
+
+/**One compact record per transcendence activation, copied by value into the telemetry ring buffer*/
+struct FRPGTranscendenceActivationRecord
+{
+	/**UTC time of the activation*/
+	FDateTime StartTime;
+
+	FName AbilityClassName;
+
+	/**Recorded by the server or by the predicting client*/
+	bool bHasAuthority = false;
+
+	float DurationSeconds = 0.f;
+
+	/**Hammers that joined the orbit, as actors or as instances*/
+	int32 NumHammersSpawned = 0;
+
+	/**Seconds from the activation to the first used hammer, negative if none was used*/
+	float TimeToFirstUseSeconds = -1.f;
+
+	int32 NumFireUses = 0;
+
+	int32 NumControlUses = 0;
+
+	int32 NumEnemiesControlled = 0;
+
+	/**Game thread time of the ability and of the orbit of its hammers, the orbit computed on the workers is not included*/
+	double GameThreadMs = 0.0;
+
+	int32 PeakActiveHammers = 0;
+
+	ERPGTranscendenceEndReason EndReason = ERPGTranscendenceEndReason::Ended;
+};
+
+/**
+ * Activation records are written to Saved/Telemetry by a background thread (RPG.Transcendence.Telemetry).
+ * The game thread only copies the record into a fixed size lock-free ring buffer, a full buffer drops the record instead of waiting.
+ */
+namespace RPGTranscendenceTelemetry
+{
+	/**Queue the record for the writer thread, never blocks*/
+	ACTIONRPG_API void SubmitActivationRecord(const FRPGTranscendenceActivationRecord& Record);
+
+	/**Write the queued records and stop the writer thread, called on exit*/
+	ACTIONRPG_API void Shutdown();
+
+	ACTIONRPG_API const TCHAR* LexToString(const ERPGTranscendenceEndReason EndReason);
+}
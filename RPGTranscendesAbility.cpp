@@ -3,10 +3,26 @@
 
 #include "SergioTestContentClasses/RPGTranscendesAbility.h"
 #include "SergioTestContentClasses/RPGTranscendenceHammer.h"
+#include "SergioTestContentClasses/RPGTranscendenceHammerSubsystem.h"
+#include "SergioTestContentClasses/RPGTranscendenceHammerPool.h"
+#include "SergioTestContentClasses/RPGEnemySpatialGridSubsystem.h"
+#include "SergioTestContentClasses/RPGFactionComponent.h"
+#include "SergioTestContentClasses/RPGHammerFormation.h"
+#include "SergioTestContentClasses/RPGTranscendenceStats.h"
+#include "SergioTestContentClasses/RPGAttributeWatcherSubsystem.h"
 #include "Abilities/RPGAbilityTask_PlayMontageAndWaitForEvent.h"
 #include "Abilities/Tasks/AbilityTask_WaitGameplayEvent.h"
 #include "Abilities/Tasks/AbilityTask_WaitGameplayEffectRemoved.h"
 #include "RPGCharacterBase.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/AssetManager.h"
+#include "EngineUtils.h"
+#include "UObject/UObjectIterator.h"
+#include "UObject/UObjectHash.h"
+#include "UObject/Package.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogRPGTranscendence, Log, All);
 
 
 URPGTranscendesAbility::URPGTranscendesAbility()
@@ -18,234 +34,1134 @@ URPGTranscendesAbility::URPGTranscendesAbility()
 	bHasToSendHammerFire = false;
 	CurrentIndexHammerToUse = 0;
 	NextUseHammerIndexToUse = 0;
+	NumPrewarmedHammers = 0;
+	HammerNetMode = ERPGHammerNetMode::ReplicatedActors;
+	OrbitReplicationComponent = nullptr;
+	bUseActorlessOrbit = false;
+	ActorlessOrbitMesh = nullptr;
+	OrbitInstancedMesh = nullptr;
+	HammerFadeInSeconds = 0.25f;
+	ActivationWorldTime = 0.f;
+	PendingEndReason = ERPGTranscendenceEndReason::Ended;
+	bIsRecordingActivation = false;
+	bHasControlTargetsResult = false;
+	bUseControlVolley = false;
+	MaxVolleyTargets = 0;
+	VolleyDistanceWeight = 1.f;
+	VolleyFacingWeight = 0.5f;
+	VolleyThreatWeight = 0.25f;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::OnGiveAbility(const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilitySpec& Spec)
+{
+	Super::OnGiveAbility(ActorInfo, Spec);
+
+	//Characters without the ability never load its hammer, montages and effect
+	RequestTranscendenceAssets();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::OnRemoveAbility(const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilitySpec& Spec)
+{
+	AActor* AvatarActor = ActorInfo ? ActorInfo->AvatarActor.Get() : nullptr;
+	URPGTranscendenceHammerPool* HammerPool = IsValid(AvatarActor) ? AvatarActor->GetWorld()->GetSubsystem<URPGTranscendenceHammerPool>() : nullptr;
+	if (IsValid(HammerPool) && NumPrewarmedHammers > 0)
+	{
+		HammerPool->ReleasePrewarmedHammers(GetHammerClass(), NumPrewarmedHammers);
+		NumPrewarmedHammers = 0;
+	}
+
+	if (TranscendenceAssetsHandle.IsValid())
+	{
+		TranscendenceAssetsHandle->ReleaseHandle();
+		TranscendenceAssetsHandle.Reset();
+	}
+
+	Super::OnRemoveAbility(ActorInfo, Spec);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::RequestTranscendenceAssets()
+{
+	if (TranscendenceAssetsHandle.IsValid())
+	{
+		return;
+	}
+
+	TArray<FSoftObjectPath> AssetPaths;
+	GetTranscendenceAssetPaths(AssetPaths);
+
+	TranscendenceAssetsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetPaths,
+		FStreamableDelegate::CreateUObject(this, &URPGTranscendesAbility::OnTranscendenceAssetsLoaded), FStreamableManager::AsyncLoadHighPriority);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::OnTranscendenceAssetsLoaded()
+{
+	ARPGCharacterBase* OwnerCharacter = Cast<ARPGCharacterBase>(GetAvatarActorFromActorInfo());
+	if (!IsValid(OwnerCharacter) || !IsValid(GetHammerClass()) || NumPrewarmedHammers > 0)
+	{
+		return;
+	}
+
+	//Construct the hammers now so the activation only has to activate them
+	URPGTranscendenceHammerPool* HammerPool = OwnerCharacter->GetWorld()->GetSubsystem<URPGTranscendenceHammerPool>();
+	if (IsValid(HammerPool))
+	{
+		NumPrewarmedHammers = OwnerCharacter->GetAttributeSet()->GetNumberOfHammers();
+		HammerPool->PrewarmHammers(GetHammerClass(), NumPrewarmedHammers);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGTranscendesAbility::AreTranscendenceAssetsLoaded() const
+{
+	TArray<FSoftObjectPath> AssetPaths;
+	GetTranscendenceAssetPaths(AssetPaths);
+	for (const FSoftObjectPath& AssetPath : AssetPaths)
+	{
+		if (!AssetPath.ResolveObject())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::GetTranscendenceAssetPaths(TArray<FSoftObjectPath>& OutAssetPaths) const
+{
+	const FSoftObjectPath SoftReferences[] =
+	{
+		HammerClassToSpawn.ToSoftObjectPath(),
+		TranscendenceAttackFireMontage.ToSoftObjectPath(),
+		TranscendenceAttackControlMontage.ToSoftObjectPath(),
+		TranscendenceEffectSubclass.ToSoftObjectPath()
+	};
+
+	for (const FSoftObjectPath& SoftReference : SoftReferences)
+	{
+		if (SoftReference.IsValid())
+		{
+			OutAssetPaths.AddUnique(SoftReference);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::ActivateAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, const FGameplayEventData* TriggerEventData)
+{  
+	Super::ActivateAbility(Handle, ActorInfo, ActivationInfo, TriggerEventData);
+
+	//Readiness gate: nothing is committed until the streamed assets are in memory
+	if (!AreTranscendenceAssetsLoaded())
+	{
+		UE_LOG(LogRPGTranscendence, Verbose, TEXT("%s activated before its assets finished streaming, activation refused"), *GetName());
+		RequestTranscendenceAssets();
+		EndAbility(Handle, ActorInfo, ActivationInfo, true, true);
+		return;
+	}
+
+	const bool bValidCommint = CommitAbility(Handle, ActorInfo, ActivationInfo);
+	if (!bValidCommint)
+	{
+		EndAbility(Handle, ActorInfo, ActivationInfo, true, false);
+		return;
+	}
+
+	PlayerCharacterReference = Cast<ARPGCharacterBase>(GetAvatarActorFromActorInfo());
+	PlayerAbilitySystemRef = PlayerCharacterReference->GetAbilitySystemComponent();
+	if (!IsValid(PlayerCharacterReference) || !IsValid(PlayerAbilitySystemRef))
+	{
+		EndAbility(Handle, ActorInfo, ActivationInfo, true, false);
+		return;
+	}
+
+	PlayerAbilitySystemRef = PlayerCharacterReference->GetAbilitySystemComponent();
+	const TSubclassOf<UGameplayEffect> TranscendenceEffectClass = TranscendenceEffectSubclass.Get();
+	if (!IsValid(TranscendenceEffectClass))
+	{
+		EndAbility(Handle, ActorInfo, ActivationInfo, true, false);
+		return;
+	}
+
+	BeginActivationRecord(ActivationInfo);
+	FRPGTelemetryCycleScope TelemetryScope(ActivationCycles);
+
+	//Apply the transcendence effect and bind the end effect by atribute duration finish
+	const FGameplayEffectContextHandle& EffectContext = PlayerAbilitySystemRef->MakeEffectContext();
+	const FGameplayEffectSpecHandle& TranscendenceModeSpecHandle = PlayerAbilitySystemRef->MakeOutgoingSpec(TranscendenceEffectClass, 1.f, EffectContext);
+	TranscendenceEffectHandle = PlayerAbilitySystemRef->ApplyGameplayEffectSpecToSelf(*TranscendenceModeSpecHandle.Data.Get());
+
+	UAbilityTask_WaitGameplayEffectRemoved* TranscendenceRemove = UAbilityTask_WaitGameplayEffectRemoved::WaitForGameplayEffectRemoved(this, TranscendenceEffectHandle);
+	if (IsValid(TranscendenceRemove))
+	{
+		TranscendenceRemove->OnRemoved.AddDynamic(this, &URPGTranscendesAbility::OnTranscendenceEffectRemoved);
+		TranscendenceRemove->ReadyForActivation();
+	}
+	
+	//Event to determine if the player is mana Out, only fired when the drain crosses zero and removed in EndAbility
+	URPGAttributeWatcherSubsystem* AttributeWatcher = GetWorld()->GetSubsystem<URPGAttributeWatcherSubsystem>();
+	if (IsValid(AttributeWatcher))
+	{
+		AttributeWatcher->WatchAttributeThreshold(PlayerAbilitySystemRef, PlayerCharacterReference->GetAttributeSet()->GetManaAttribute(), 0.f, ERPGAttributeThresholdCrossing::FallsToOrBelow,
+			this, FOnRPGAttributeThresholdCrossed::CreateUObject(this, &URPGTranscendesAbility::OnManaDepleted), true);
+	}
+
+	//The server knows when the drain will empty the mana, the deadline is only recomputed when the drain rate changes
+	if (HasAuthority(&ActivationInfo))
+	{
+		DrainEffectAddedHandle = PlayerAbilitySystemRef->OnActiveGameplayEffectAddedDelegateToSelf.AddUObject(this, &URPGTranscendesAbility::OnDrainEffectAdded);
+		DrainEffectRemovedHandle = PlayerAbilitySystemRef->OnAnyGameplayEffectRemovedDelegate().AddUObject(this, &URPGTranscendesAbility::OnDrainEffectRemoved);
+		ScheduleManaDepletionDeadline();
+	}
+
+	//Activated with no mana left, the deadline already ended the ability
+	if (!IsActive())
+	{
+		return;
+	}
+
+	//Ability Communication events FIRE from the BP_CharacterPlayer
+	AddWaitGameplayEvent(TranscendenceCancelTag);
+	AddWaitGameplayEvent(StartFireProjectileHammerTag);
+	AddWaitGameplayEvent(StartControlEnemyHammerTag);
+	
+	//A hammer use carries its hammer index in a uint8
+	CurrentNumberOfHammers = FMath::Min(PlayerCharacterReference->GetAttributeSet()->GetNumberOfHammers(), MAX_uint8 + 1);
+
+	//The replicated orbit keeps one bit per hammer, the server and the predicting owner spawn the same capped count
+	if (HammerNetMode == ERPGHammerNetMode::ClientSimulated)
+	{
+		CurrentNumberOfHammers = FMath::Min(CurrentNumberOfHammers, URPGHammerOrbitReplicationComponent::MaxReplicatedHammers);
+	}
+
+	if (CurrentNumberOfHammers > 0 && IsValid(GetHammerClass()))
+	{
+		RPG_TRANSCENDENCE_SCOPE(STAT_RPGTranscendence_SpawnHammers);
+
+		//All the hammers of the player are advanced together by the world orbit manager
+		URPGTranscendenceHammerSubsystem* OrbitSubsystem = GetWorld()->GetSubsystem<URPGTranscendenceHammerSubsystem>();
+		if (IsValid(OrbitSubsystem))
+		{
+			OrbitSubsystem->RegisterOrbitOwner(PlayerCharacterReference, CurrentNumberOfHammers);
+		}
+
+		//In client simulated mode the hammers stay local to every machine and only the orbit descriptor is replicated
+		if (HammerNetMode == ERPGHammerNetMode::ClientSimulated && HasAuthority(&ActivationInfo))
+		{
+			OrbitReplicationComponent = URPGHammerOrbitReplicationComponent::FindOrAddOrbitReplicationComponent(PlayerCharacterReference);
+			if (IsValid(OrbitReplicationComponent))
+			{
+				const bool bOwnerRunsAbility = GetNetExecutionPolicy() == EGameplayAbilityNetExecutionPolicy::LocalPredicted;
+				OrbitReplicationComponent->BeginReplicatedOrbit(GetHammerClass(), CurrentNumberOfHammers, bOwnerRunsAbility);
+			}
+		}
+
+		FormationHammerIndices.Reset(CurrentNumberOfHammers);
+		for (int32 HammerIndex = 0; HammerIndex < CurrentNumberOfHammers; HammerIndex++)
+		{
+			FormationHammerIndices.Add(HammerIndex);
+		}
+
+		if (bUseActorlessOrbit && IsValid(ActorlessOrbitMesh))
+		{
+			SpawnOrbitInstances();
+		}
+		else
+		{
+			RequestAbilityHammers();
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+ARPGTranscendenceHammer* URPGTranscendesAbility::AcquireAbilityHammer(const int32 HammerIndex, const float InitialAngleAxis)
+{
+	URPGTranscendenceHammerPool* HammerPool = GetWorld()->GetSubsystem<URPGTranscendenceHammerPool>();
+	if (!IsValid(HammerPool))
+	{
+		return nullptr;
+	}
+
+	ARPGTranscendenceHammer* Hammer = HammerPool->AcquireHammer(GetHammerClass(), PlayerCharacterReference, HammerIndex, InitialAngleAxis);
+	if (!IsValid(Hammer))
+	{
+		return nullptr;
+	}
+
+	ApplyAbilityNetMode(Hammer);
+	return Hammer;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::ApplyAbilityNetMode(ARPGTranscendenceHammer* Hammer) const
+{
+	//Pooled hammers may come from an activation with the other net mode
+	const bool bReplicateHammer = HammerNetMode == ERPGHammerNetMode::ReplicatedActors && GetHammerClass().GetDefaultObject()->GetIsReplicated();
+	if (Hammer->GetIsReplicated() != bReplicateHammer && Hammer->HasAuthority())
+	{
+		Hammer->SetReplicates(bReplicateHammer);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::RequestAbilityHammers()
+{
+	URPGTranscendenceHammerPool* HammerPool = GetWorld()->GetSubsystem<URPGTranscendenceHammerPool>();
+	if (!IsValid(HammerPool))
+	{
+		return;
+	}
+
+	//The slots are filled as the hammers arrive so the array index is still the hammer index
+	AbilityCurrentHammersRefs.SetNumZeroed(CurrentNumberOfHammers);
+	for (int32 HammerIndex = 0; HammerIndex < CurrentNumberOfHammers; HammerIndex++)
+	{
+		HammerPool->RequestHammer(this, GetHammerClass(), PlayerCharacterReference, HammerIndex, RPGHammerFormation::InitialSlotAngle(HammerIndex, CurrentNumberOfHammers),
+			FOnRPGHammerAcquired::CreateUObject(this, &URPGTranscendesAbility::OnAbilityHammerAcquired, HammerIndex));
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::OnAbilityHammerAcquired(ARPGTranscendenceHammer* Hammer, const int32 HammerIndex)
+{
+	if (!IsValid(Hammer) || !AbilityCurrentHammersRefs.IsValidIndex(HammerIndex))
+	{
+		return;
+	}
+
+	FRPGTelemetryCycleScope TelemetryScope(ActivationCycles);
+	ActivationRecord.NumHammersSpawned++;
+
+	ApplyAbilityNetMode(Hammer);
+	AbilityCurrentHammersRefs[HammerIndex] = Hammer;
+
+	//The first hammers kept orbiting while this one waited, join them at the slot of its rank in the current formation, uses may have re-spaced it
+	URPGTranscendenceHammerSubsystem* OrbitSubsystem = GetWorld()->GetSubsystem<URPGTranscendenceHammerSubsystem>();
+	const int32 FormationRank = FormationHammerIndices.Find(HammerIndex);
+	const int32 FormationSize = FormationHammerIndices.Num();
+	for (int32 ReferenceRank = 0; ReferenceRank < FormationSize && FormationRank != INDEX_NONE; ReferenceRank++)
+	{
+		const int32 ReferenceIndex = FormationHammerIndices[ReferenceRank];
+		const FRPGHammerOrbitState* ReferenceState = ReferenceIndex != HammerIndex && IsValid(OrbitSubsystem) ? OrbitSubsystem->FindOrbitState(PlayerCharacterReference, ReferenceIndex) : nullptr;
+		if (!ReferenceState || ReferenceState->bIsInSpinningMode)
+		{
+			continue;
+		}
+
+		const float SlotAngleOffset = RPGHammerFormation::SlotAngle(FormationRank, FormationSize) - RPGHammerFormation::SlotAngle(ReferenceRank, FormationSize);
+		const FVector& RotateAxisVector = ReferenceState->GetTuning()->RotateAxisVector;
+
+		FRPGHammerOrbitState JoinedState = *ReferenceState;
+		JoinedState.RotationAngleAxis = FRotator::ClampAxis(ReferenceState->RotationAngleAxis + SlotAngleOffset);
+		JoinedState.OrbitOffset = ReferenceState->OrbitOffset.RotateAngleAxis(SlotAngleOffset, RotateAxisVector);
+		JoinedState.PreviousOrbitOffset = ReferenceState->PreviousOrbitOffset.RotateAngleAxis(SlotAngleOffset, RotateAxisVector);
+		OrbitSubsystem->RestoreOrbitState(PlayerCharacterReference, HammerIndex, JoinedState);
+		break;
+	}
+
+	Hammer->BP_FadeInHammer(HammerFadeInSeconds);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::ServePendingAbilityHammer(const int32 HammerIndex)
+{
+	if (!AbilityCurrentHammersRefs.IsValidIndex(HammerIndex) || IsValid(AbilityCurrentHammersRefs[HammerIndex]))
+	{
+		return;
+	}
+
+	URPGTranscendenceHammerPool* HammerPool = GetWorld()->GetSubsystem<URPGTranscendenceHammerPool>();
+	if (IsValid(HammerPool))
+	{
+		HammerPool->ServeHammerRequestNow(this, HammerIndex);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::SpawnOrbitInstances()
+{
+	URPGTranscendenceHammerSubsystem* OrbitSubsystem = GetWorld()->GetSubsystem<URPGTranscendenceHammerSubsystem>();
+	if (!IsValid(OrbitSubsystem))
+	{
+		return;
+	}
+
+	//One component for all the hammers instead of one actor with its own components per hammer
+	if (!IsValid(OrbitInstancedMesh) || OrbitInstancedMesh->GetOwner() != PlayerCharacterReference)
+	{
+		OrbitInstancedMesh = NewObject<UInstancedStaticMeshComponent>(PlayerCharacterReference);
+		OrbitInstancedMesh->SetMobility(EComponentMobility::Movable);
+		OrbitInstancedMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		OrbitInstancedMesh->SetCanEverAffectNavigation(false);
+		OrbitInstancedMesh->SetAbsolute(true, true, true);
+		OrbitInstancedMesh->RegisterComponent();
+	}
+	OrbitInstancedMesh->SetStaticMesh(ActorlessOrbitMesh);
+	OrbitInstancedMesh->ClearInstances();
+	OrbitInstancedMesh->SetVisibility(true);
+
+	const FTransform& PlayerTransform = PlayerCharacterReference->GetActorTransform();
+	FRPGHammerOrbitState InitialOrbitState = GetHammerClass().GetDefaultObject()->MakeOrbitState();
+	InitialOrbitState.PreviewForwardVectorToCompare = PlayerCharacterReference->GetActorForwardVector();
+
+	//The actors are acquired on use, keep their slots so the array index is still the hammer index
+	AbilityCurrentHammersRefs.SetNumZeroed(CurrentNumberOfHammers);
+	for (int32 HammerIndex = 0; HammerIndex < CurrentNumberOfHammers; HammerIndex++)
+	{
+		OrbitInstancedMesh->AddInstance(PlayerTransform, true);
+
+		InitialOrbitState.RotationAngleAxis = RPGHammerFormation::InitialSlotAngle(HammerIndex, CurrentNumberOfHammers);
+		OrbitSubsystem->RegisterInstance(PlayerCharacterReference, OrbitInstancedMesh, HammerIndex, InitialOrbitState);
+		ActivationRecord.NumHammersSpawned++;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+ARPGTranscendenceHammer* URPGTranscendesAbility::PromoteOrbitInstance(const int32 HammerIndex)
+{
+	URPGTranscendenceHammerSubsystem* OrbitSubsystem = GetWorld()->GetSubsystem<URPGTranscendenceHammerSubsystem>();
+	FRPGHammerOrbitState InstanceOrbitState;
+	if (!IsValid(OrbitSubsystem) || !OrbitSubsystem->UnregisterInstance(PlayerCharacterReference, HammerIndex, &InstanceOrbitState))
+	{
+		return nullptr;
+	}
+
+	ARPGTranscendenceHammer* PromotedHammer = AcquireAbilityHammer(HammerIndex, InstanceOrbitState.RotationAngleAxis);
+	if (IsValid(PromotedHammer))
+	{
+		//Continue with the speed, radius and spinning state the instance already had
+		OrbitSubsystem->RestoreOrbitState(PlayerCharacterReference, HammerIndex, InstanceOrbitState);
+		AbilityCurrentHammersRefs[HammerIndex] = PromotedHammer;
+	}
+
+	return PromotedHammer;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGTranscendesAbility::IsOrbitInstance(const int32 HammerIndex) const
+{
+	URPGTranscendenceHammerSubsystem* OrbitSubsystem = GetWorld()->GetSubsystem<URPGTranscendenceHammerSubsystem>();
+	const FRPGHammerOrbitState* OrbitState = IsValid(OrbitSubsystem) ? OrbitSubsystem->FindOrbitState(PlayerCharacterReference, HammerIndex) : nullptr;
+	return OrbitState && OrbitState->bIsInstance;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::EndAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, bool bReplicateEndAbility, bool bWasCancelled)
+{
+	//Stop watching the mana before anything else, also when the activation failed
+	URPGAttributeWatcherSubsystem* AttributeWatcher = GetWorld()->GetSubsystem<URPGAttributeWatcherSubsystem>();
+	if (IsValid(AttributeWatcher))
+	{
+		AttributeWatcher->RemoveWatchers(this);
+	}
+
+	ClearManaDepletionDeadline();
+
+	//Before the hammers and the orbit group are released, the record reads them
+	FinishActivationRecord(bWasCancelled);
+
+	//Activations refused before the references are set still have to end in the base ability
+	if (!IsValid(PlayerCharacterReference) || !IsValid(PlayerAbilitySystemRef))
+	{
+		Super::EndAbility(Handle, ActorInfo, ActivationInfo, bReplicateEndAbility, bWasCancelled);
+		return;
+	}
+
+	UAnimMontage* CurrentTranscendenceMontage = PlayerCharacterReference->GetCurrentMontage();
+	if (IsValid(CurrentTranscendenceMontage))
+	{
+		PlayerCharacterReference->StopAnimMontage(CurrentTranscendenceMontage);
+	}
+
+	// Was the ability cancel by drain mana or cancel manually
+	const bool PlayerStillEffect = TranscendenceTag.IsValid() && PlayerAbilitySystemRef->HasMatchingGameplayTag(TranscendenceTag);
+	if (PlayerStillEffect)
+	{
+		PlayerAbilitySystemRef->RemoveActiveGameplayEffect(TranscendenceEffectHandle);	
+	}
+
+	//Stop Drain Mana
+	if (DrainingManaTag.IsValid())
+	{
+		FGameplayTagContainer TagContainer;
+		TagContainer.AddTag(DrainingManaTag);
+		PlayerAbilitySystemRef->RemoveActiveEffectsWithGrantedTags(TagContainer);
+	}
+
+	
+	//Set defaults controls enemies
+	for (ARPGCharacterBase* CurrentEnemyRef : AbilityCurrentEnemyRefs)
+	{
+		URPGFactionComponent* EnemyFaction = URPGFactionComponent::FindOrAddFactionComponent(CurrentEnemyRef);
+		if (IsValid(EnemyFaction))
+		{
+			//The NPC becomes again "Enemy"
+			EnemyFaction->SetControlledByPlayer(false);
+		}
+	}
+
+	//Return Hammers to the pool, the ones still waiting for spawn budget are never acquired
+	URPGTranscendenceHammerPool* HammerPool = GetWorld()->GetSubsystem<URPGTranscendenceHammerPool>();
+	if (IsValid(HammerPool))
+	{
+		HammerPool->CancelHammerRequests(this);
+		for (ARPGTranscendenceHammer* CurrentHammerRef : AbilityCurrentHammersRefs)
+		{
+			if (IsValid(CurrentHammerRef))
+			{
+				HammerPool->ReleaseHammer(CurrentHammerRef);
+			}
+		}
+	}
+
+	URPGTranscendenceHammerSubsystem* OrbitSubsystem = GetWorld()->GetSubsystem<URPGTranscendenceHammerSubsystem>();
+	if (IsValid(OrbitSubsystem))
+	{
+		OrbitSubsystem->UnregisterOrbitOwner(PlayerCharacterReference);
+	}
+
+	if (IsValid(OrbitInstancedMesh))
+	{
+		OrbitInstancedMesh->ClearInstances();
+		OrbitInstancedMesh->SetVisibility(false);
+	}
+
+	if (IsValid(OrbitReplicationComponent))
+	{
+		OrbitReplicationComponent->EndReplicatedOrbit();
+		OrbitReplicationComponent = nullptr;
+	}
+
+	//Sanity Defaults
+	AbilityCurrentEnemyRefs.Empty();
+	AbilityControlledEnemiesSet.Empty();
+	AbilityCurrentHammersRefs.Empty();
+	FormationHammerIndices.Empty();
+	ResetControlTargetsQuery();
+	bHasToSendHammerFire = false;
+	CurrentIndexHammerToUse = 0;
+	NextUseHammerIndexToUse = 0;
+
+   BP_EndAbility();
+
+   Super::EndAbility(Handle, ActorInfo, ActivationInfo, bReplicateEndAbility, bWasCancelled);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::BeginActivationRecord(const FGameplayAbilityActivationInfo& ActivationInfo)
+{
+	ActivationRecord = FRPGTranscendenceActivationRecord();
+	ActivationRecord.StartTime = FDateTime::UtcNow();
+	ActivationRecord.AbilityClassName = GetClass()->GetFName();
+	ActivationRecord.bHasAuthority = HasAuthority(&ActivationInfo);
+
+	ActivationWorldTime = GetWorld()->GetTimeSeconds();
+	ActivationCycles.Reset();
+	PendingEndReason = ERPGTranscendenceEndReason::Ended;
+	bIsRecordingActivation = true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::FinishActivationRecord(const bool bWasCancelled)
+{
+	//Removing the transcendence effect in EndAbility ends the ability a second time
+	if (!bIsRecordingActivation)
+	{
+		return;
+	}
+	bIsRecordingActivation = false;
+
+	ActivationRecord.DurationSeconds = GetWorld()->GetTimeSeconds() - ActivationWorldTime;
+	ActivationRecord.NumEnemiesControlled = AbilityCurrentEnemyRefs.Num();
+	const bool bIsExternalCancel = bWasCancelled && PendingEndReason == ERPGTranscendenceEndReason::Ended;
+	ActivationRecord.EndReason = bIsExternalCancel ? ERPGTranscendenceEndReason::Cancelled : PendingEndReason;
+
+	//The orbit of the hammers is measured by the subsystem per player
+	int32 PeakActiveHammers = 0;
+	double OrbitGameThreadMs = 0.0;
+	URPGTranscendenceHammerSubsystem* OrbitSubsystem = GetWorld()->GetSubsystem<URPGTranscendenceHammerSubsystem>();
+	if (IsValid(OrbitSubsystem))
+	{
+		OrbitSubsystem->GetOrbitOwnerTelemetry(PlayerCharacterReference, PeakActiveHammers, OrbitGameThreadMs);
+	}
+	ActivationRecord.PeakActiveHammers = PeakActiveHammers;
+	ActivationRecord.GameThreadMs = ActivationCycles.GetMilliseconds() + OrbitGameThreadMs;
+
+	RPGTranscendenceTelemetry::SubmitActivationRecord(ActivationRecord);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::OnManaDepleted(float NewManaValue)
+{
+	PendingEndReason = ERPGTranscendenceEndReason::ManaOut;
+	EndAbility(CurrentSpecHandle, CurrentActorInfo, CurrentActivationInfo, true, false);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::ScheduleManaDepletionDeadline()
+{
+	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+	TimerManager.ClearTimer(ManaDepletionDeadlineHandle);
+
+	TArray<FRPGManaDrainSource> DrainSources;
+	GatherManaDrainSources(DrainSources);
+
+	const float CurrentMana = PlayerCharacterReference->GetAttributeSet()->GetMana();
+	const float DepletionDelay = PredictManaDepletionDelay(CurrentMana, PlayerCharacterReference->GetAttributeSet()->GetMaxMana(), DrainSources);
+	if (DepletionDelay < 0.f)
+	{
+		return;
+	}
+
+	if (DepletionDelay <= KINDA_SMALL_NUMBER)
+	{
+		OnManaDepleted(CurrentMana);
+		return;
+	}
+
+	TimerManager.SetTimer(ManaDepletionDeadlineHandle, this, &URPGTranscendesAbility::OnManaDepletionDeadline, DepletionDelay, false);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::OnManaDepletionDeadline()
+{
+	if (!IsValid(PlayerCharacterReference) || !IsValid(PlayerAbilitySystemRef))
+	{
+		return;
+	}
+
+	TArray<FRPGManaDrainSource> DrainSources;
+	GatherManaDrainSources(DrainSources);
+
+	const float CurrentMana = PlayerCharacterReference->GetAttributeSet()->GetMana();
+	const float DepletionDelay = PredictManaDepletionDelay(CurrentMana, PlayerCharacterReference->GetAttributeSet()->GetMaxMana(), DrainSources);
+
+	float NextDrainTickDelay = MAX_flt;
+	for (const FRPGManaDrainSource& DrainSource : DrainSources)
+	{
+		NextDrainTickDelay = FMath::Min(NextDrainTickDelay, DrainSource.TimeToNextTick);
+	}
+
+	//The mana is out or the next drain tick takes the rest, waiting for that tick would only move the end by one frame
+	if (CurrentMana <= 0.f || (DepletionDelay >= 0.f && DepletionDelay <= NextDrainTickDelay))
+	{
+		OnManaDepleted(CurrentMana);
+		return;
+	}
+
+	//A restore or an extra cost since the prediction moved the deadline
+	ScheduleManaDepletionDeadline();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::GatherManaDrainSources(TArray<FRPGManaDrainSource>& OutDrainSources) const
+{
+	const FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+
+	//The restores are found among all the effects, GetManaPerTick filters the drains by their owning tag
+	for (const FActiveGameplayEffectHandle& EffectHandle : PlayerAbilitySystemRef->GetActiveEffects(FGameplayEffectQuery()))
+	{
+		const FActiveGameplayEffect* ActiveEffect = PlayerAbilitySystemRef->GetActiveGameplayEffect(EffectHandle);
+		if (!ActiveEffect || ActiveEffect->bIsInhibited)
+		{
+			continue;
+		}
+
+		const float ManaPerTick = GetManaPerTick(ActiveEffect->Spec);
+		if (ManaPerTick == 0.f)
+		{
+			continue;
+		}
+
+		FRPGManaDrainSource& DrainSource = OutDrainSources.AddDefaulted_GetRef();
+		DrainSource.Period = ActiveEffect->GetPeriod();
+		DrainSource.TimeToNextTick = FMath::Max(TimerManager.GetTimerRemaining(ActiveEffect->PeriodHandle), 0.f);
+		DrainSource.ManaPerTick = ManaPerTick;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+float URPGTranscendesAbility::GetManaPerTick(const FGameplayEffectSpec& Spec) const
+{
+	if (!Spec.Def || Spec.GetPeriod() <= 0.f || !IsValid(PlayerCharacterReference))
+	{
+		return 0.f;
+	}
+
+	float ManaPerTick = 0.f;
+	const FGameplayAttribute ManaAttribute = PlayerCharacterReference->GetAttributeSet()->GetManaAttribute();
+	const TArray<FGameplayModifierInfo>& Modifiers = Spec.Def->Modifiers;
+	for (int32 ModifierIndex = 0; ModifierIndex < Modifiers.Num(); ModifierIndex++)
+	{
+		if (Modifiers[ModifierIndex].Attribute == ManaAttribute && Modifiers[ModifierIndex].ModifierOp == EGameplayModOp::Additive)
+		{
+			ManaPerTick -= Spec.GetModifierMagnitude(ModifierIndex, true);
+		}
+	}
+
+	//Only the drains owning the draining tag end the ability, every periodic restore delays it
+	if (ManaPerTick > 0.f)
+	{
+		const bool bIsDrain = DrainingManaTag.IsValid() && FGameplayEffectQuery::MakeQuery_MatchAnyOwningTags(FGameplayTagContainer(DrainingManaTag)).Matches(Spec);
+		return bIsDrain ? ManaPerTick : 0.f;
+	}
+	return ManaPerTick;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGTranscendesAbility::IsManaDrainSpec(const FGameplayEffectSpec& Spec) const
+{
+	return GetManaPerTick(Spec) != 0.f;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::OnDrainEffectAdded(UAbilitySystemComponent* AbilitySystem, const FGameplayEffectSpec& Spec, FActiveGameplayEffectHandle ActiveHandle)
+{
+	if (IsManaDrainSpec(Spec))
+	{
+		ScheduleManaDepletionDeadline();
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::OnDrainEffectRemoved(const FActiveGameplayEffect& RemovedEffect)
+{
+	if (IsManaDrainSpec(RemovedEffect.Spec))
+	{
+		ScheduleManaDepletionDeadline();
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::ClearManaDepletionDeadline()
+{
+	GetWorld()->GetTimerManager().ClearTimer(ManaDepletionDeadlineHandle);
+
+	if (IsValid(PlayerAbilitySystemRef))
+	{
+		PlayerAbilitySystemRef->OnActiveGameplayEffectAddedDelegateToSelf.Remove(DrainEffectAddedHandle);
+		PlayerAbilitySystemRef->OnAnyGameplayEffectRemovedDelegate().Remove(DrainEffectRemovedHandle);
+	}
+	DrainEffectAddedHandle.Reset();
+	DrainEffectRemovedHandle.Reset();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+float URPGTranscendesAbility::PredictManaDepletionDelay(const float CurrentMana, const float MaxMana, const TArray<FRPGManaDrainSource>& DrainSources)
+{
+	if (CurrentMana <= 0.f)
+	{
+		return 0.f;
+	}
+
+	//Restores alone never empty the mana
+	const bool bHasDrain = DrainSources.ContainsByPredicate([](const FRPGManaDrainSource& DrainSource) { return DrainSource.ManaPerTick > 0.f; });
+	if (!bHasDrain)
+	{
+		return -1.f;
+	}
+
+	//A single drain, the usual case, is solved directly
+	if (DrainSources.Num() == 1)
+	{
+		const FRPGManaDrainSource& DrainSource = DrainSources[0];
+		const int32 NumTicks = FMath::CeilToInt(CurrentMana / DrainSource.ManaPerTick);
+		return DrainSource.TimeToNextTick + (NumTicks - 1) * DrainSource.Period;
+	}
+
+	//Several drains and restores with different periods are stepped tick by tick in time order, the restores stop at the max mana
+	TArray<float, TInlineAllocator<4>> NextTickTimes;
+	for (const FRPGManaDrainSource& DrainSource : DrainSources)
+	{
+		NextTickTimes.Add(DrainSource.TimeToNextTick);
+	}
+
+	constexpr int32 MaxSimulatedTicks = 4096;
+	float RemainingMana = CurrentMana;
+	for (int32 SimulatedTick = 0; SimulatedTick < MaxSimulatedTicks; SimulatedTick++)
+	{
+		int32 NextSourceIndex = 0;
+		for (int32 SourceIndex = 1; SourceIndex < NextTickTimes.Num(); SourceIndex++)
+		{
+			if (NextTickTimes[SourceIndex] < NextTickTimes[NextSourceIndex])
+			{
+				NextSourceIndex = SourceIndex;
+			}
+		}
+
+		RemainingMana = FMath::Min(RemainingMana - DrainSources[NextSourceIndex].ManaPerTick, MaxMana);
+		if (RemainingMana <= 0.f)
+		{
+			return NextTickTimes[NextSourceIndex];
+		}
+		NextTickTimes[NextSourceIndex] += DrainSources[NextSourceIndex].Period;
+	}
+
+	//Too far away to matter, the threshold watcher still ends the ability when the mana reaches zero
+	return -1.f;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::AddWaitGameplayEvent(const FGameplayTag& Tag)
+{
+	if (!Tag.IsValid())
+	{
+		return;
+	}
+
+	UAbilityTask_WaitGameplayEvent* WaitEventTask = UAbilityTask_WaitGameplayEvent::WaitGameplayEvent(this, Tag);
+	if (IsValid(WaitEventTask))
+	{
+		WaitEventTask->EventReceived.AddDynamic(this, &URPGTranscendesAbility::OnGameplayEventReceived);
+		WaitEventTask->ReadyForActivation();
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::OnGameplayEventReceived(FGameplayEventData Payload)
+{
+	FRPGTelemetryCycleScope TelemetryScope(ActivationCycles);
+
+    FGameplayTag CurrentEventTag = Payload.EventTag;
+	if (CurrentEventTag.IsValid())
+	{		
+		if (CurrentEventTag == TranscendenceCancelTag)
+		{
+			PendingEndReason = ERPGTranscendenceEndReason::CancelTag;
+			EndAbility(CurrentSpecHandle, CurrentActorInfo, CurrentActivationInfo, true, false);
+		}	
+
+		if (CurrentEventTag == StartFireProjectileHammerTag)
+		{
+		    bHasToSendHammerFire = true;
+			PreparetoUse();
+		}
+
+		if (CurrentEventTag == StartControlEnemyHammerTag)
+		{
+			PreparetoUse();
+		}
+    }
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-void URPGTranscendesAbility::ActivateAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, const FGameplayEventData* TriggerEventData)
-{  
-	Super::ActivateAbility(Handle, ActorInfo, ActivationInfo, TriggerEventData);
+void URPGTranscendesAbility::SendHammerToControl()
+{
+	RPG_TRANSCENDENCE_SCOPE(STAT_RPGTranscendence_SendHammerToControl);
 
-	const bool bValidCommint = CommitAbility(Handle, ActorInfo, ActivationInfo);
-	if (!bValidCommint)
+	ARPGCharacterBase* EnemyToControl = TakeQueriedControlTarget();
+
+	//The overlap was not ready or every candidate became stale, search the grid in this frame
+	if (!IsValid(EnemyToControl))
 	{
-		EndAbility(Handle, ActorInfo, ActivationInfo, true, false);
-		return;
+		URPGEnemySpatialGridSubsystem* EnemySpatialGrid = GetWorld()->GetSubsystem<URPGEnemySpatialGridSubsystem>();
+		if (!IsValid(EnemySpatialGrid))
+		{
+			return;
+		}
+
+		//Nearest enemy in reach that is not already controlled
+		EnemyToControl = EnemySpatialGrid->FindNearestCharacter(PlayerCharacterReference->GetActorLocation(), ControlEnemiesRadius, ERPGFactionFlags::Enemy, AbilityControlledEnemiesSet,
+			[this](const ARPGCharacterBase* Candidate) { return IsValidControlTarget(Candidate); });
 	}
 
-	PlayerCharacterReference = Cast<ARPGCharacterBase>(GetAvatarActorFromActorInfo());
-	PlayerAbilitySystemRef = PlayerCharacterReference->GetAbilitySystemComponent();
-	if (!IsValid(PlayerCharacterReference) || !IsValid(PlayerAbilitySystemRef))
+	if (IsValid(EnemyToControl))
 	{
-		EndAbility(Handle, ActorInfo, ActivationInfo, true, false);
-		return;
+		AbilityCurrentEnemyRefs.Add(EnemyToControl);
+		AbilityControlledEnemiesSet.Add(EnemyToControl);
+		UseHammer(true , EnemyToControl);
 	}
+}
 
-	PlayerAbilitySystemRef = PlayerCharacterReference->GetAbilitySystemComponent();
-	if (!IsValid(TranscendenceEffectSubclass))
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::RequestControlTargets()
+{
+	ResetControlTargetsQuery();
+
+	//Without object types the overlap would not find anyone, the control event uses the grid instead
+	if (ControlCollisionObjectTypes.Num() == 0)
 	{
-		EndAbility(Handle, ActorInfo, ActivationInfo, true, false);
 		return;
 	}
 
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(TranscendenceControlTargets), false, PlayerCharacterReference);
+	FOverlapDelegate OverlapDelegate;
+	OverlapDelegate.BindUObject(this, &URPGTranscendesAbility::OnControlTargetsQueryCompleted);
 
-	//Apply the transcendence effect and bind the end effect by atribute duration finish
-	const FGameplayEffectContextHandle& EffectContext = PlayerAbilitySystemRef->MakeEffectContext();
-	const FGameplayEffectSpecHandle& TranscendenceModeSpecHandle = PlayerAbilitySystemRef->MakeOutgoingSpec(TranscendenceEffectSubclass, 1.f, EffectContext);
-	TranscendenceEffectHandle = PlayerAbilitySystemRef->ApplyGameplayEffectSpecToSelf(*TranscendenceModeSpecHandle.Data.Get());
+	ControlTargetsQueryHandle = GetWorld()->AsyncOverlapByObjectType(PlayerCharacterReference->GetActorLocation(), FQuat::Identity, FCollisionObjectQueryParams(ControlCollisionObjectTypes),
+		FCollisionShape::MakeSphere(ControlEnemiesRadius), QueryParams, &OverlapDelegate);
+}
 
-	UAbilityTask_WaitGameplayEffectRemoved* TranscendenceRemove = UAbilityTask_WaitGameplayEffectRemoved::WaitForGameplayEffectRemoved(this, TranscendenceEffectHandle);
-	if (IsValid(TranscendenceRemove))
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::OnControlTargetsQueryCompleted(const FTraceHandle& TraceHandle, FOverlapDatum& OverlapDatum)
+{
+	//Result of a request that was replaced or reset
+	if (TraceHandle != ControlTargetsQueryHandle)
 	{
-		TranscendenceRemove->OnRemoved.AddDynamic(this, &URPGTranscendesAbility::OnTranscendenceEffectRemoved);
-		TranscendenceRemove->ReadyForActivation();
+		return;
 	}
-	
-	//Event to determine if the player is mana Out
-	FOnGameplayAttributeValueChange& OnManaChangedEvent = PlayerAbilitySystemRef->GetGameplayAttributeValueChangeDelegate(PlayerCharacterReference->GetAttributeSet()->GetManaAttribute());
-	OnManaChangedEvent.AddUObject(this, &URPGTranscendesAbility::OnManaChanged);
 
-	//Ability Communication events FIRE from the BP_CharacterPlayer
-	AddWaitGameplayEvent(TranscendenceCancelTag);
-	AddWaitGameplayEvent(StartFireProjectileHammerTag);
-	AddWaitGameplayEvent(StartControlEnemyHammerTag);
-	
-	CurrentNumberOfHammers = PlayerCharacterReference->GetAttributeSet()->GetNumberOfHammers();
-	if (CurrentNumberOfHammers > 0 && IsValid(HammerClassToSpawn))
+	ControlTargetCandidates.Reset(OverlapDatum.OutOverlaps.Num());
+	for (const FOverlapResult& Overlap : OverlapDatum.OutOverlaps)
 	{
-		for (int i = 0; i <= CurrentNumberOfHammers - 1; i++)
-		{		    
-			ARPGTranscendenceHammer* CurrentHammerToSpawn = GetWorld()->SpawnActorDeferred<ARPGTranscendenceHammer>(HammerClassToSpawn, PlayerCharacterReference->GetActorTransform(),PlayerCharacterReference, nullptr, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
-			if(IsValid(CurrentHammerToSpawn))
-			{
-			    CurrentHammerToSpawn->SetRotationAnglesAxis(i * (360 / CurrentNumberOfHammers));
-				CurrentHammerToSpawn->SetPreviewForwardVector(PlayerCharacterReference->GetActorForwardVector());
-				CurrentHammerToSpawn->SetCurrentHamerIndex(i);
-				CurrentHammerToSpawn->FinishSpawning(PlayerCharacterReference->GetActorTransform());
-				AbilityCurrentHammersRefs.Add(CurrentHammerToSpawn);
-			}
+		ARPGCharacterBase* Candidate = Cast<ARPGCharacterBase>(Overlap.GetActor());
+		if (Candidate)
+		{
+			ControlTargetCandidates.AddUnique(Candidate);
 		}
 	}
+	bHasControlTargetsResult = true;
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-void URPGTranscendesAbility::EndAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, bool bReplicateEndAbility, bool bWasCancelled)
+ARPGCharacterBase* URPGTranscendesAbility::TakeQueriedControlTarget()
 {
-	if (!IsValid(PlayerCharacterReference) || !IsValid(PlayerAbilitySystemRef))
+	if (!bHasControlTargetsResult)
 	{
-		return;
+		ResetControlTargetsQuery();
+		return nullptr;
 	}
 
-	UAnimMontage* CurrentTranscendenceMontage = PlayerCharacterReference->GetCurrentMontage();
-	if (IsValid(CurrentTranscendenceMontage))
+	const FVector PlayerLocation = PlayerCharacterReference->GetActorLocation();
+	ARPGCharacterBase* NearestEnemy = nullptr;
+	float NearestDistanceSquared = FMath::Square(ControlEnemiesRadius);
+	for (const TWeakObjectPtr<ARPGCharacterBase>& CandidatePtr : ControlTargetCandidates)
 	{
-		PlayerCharacterReference->StopAnimMontage(CurrentTranscendenceMontage);
+		ARPGCharacterBase* Candidate = CandidatePtr.Get();
+		if (!IsQueriedControlTargetValid(Candidate, PlayerLocation))
+		{
+			continue;
+		}
+
+		const float DistanceSquared = FVector::DistSquared(PlayerLocation, Candidate->GetActorLocation());
+		if (DistanceSquared <= NearestDistanceSquared)
+		{
+			NearestEnemy = Candidate;
+			NearestDistanceSquared = DistanceSquared;
+		}
 	}
 
-	// Was the ability cancel by drain mana or cancel manually
-	const bool PlayerStillEffect = TranscendenceTag.IsValid() && PlayerAbilitySystemRef->HasMatchingGameplayTag(TranscendenceTag);
-	if (PlayerStillEffect)
+	ResetControlTargetsQuery();
+	return NearestEnemy;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+bool URPGTranscendesAbility::IsQueriedControlTargetValid(const ARPGCharacterBase* Candidate, const FVector& PlayerLocation) const
+{
+	//The candidates are from the montage start, anyone that died, was controlled or left the reach since then is skipped
+	if (!IsValid(Candidate) || Candidate->GetHealth() <= 0.f || AbilityControlledEnemiesSet.Contains(Candidate))
 	{
-		PlayerAbilitySystemRef->RemoveActiveGameplayEffect(TranscendenceEffectHandle);	
+		return false;
 	}
 
-	//Stop Drain Mana
-	if (DrainingManaTag.IsValid())
+	if (FVector::DistSquared(PlayerLocation, Candidate->GetActorLocation()) > FMath::Square(ControlEnemiesRadius))
 	{
-		FGameplayTagContainer TagContainer;
-		TagContainer.AddTag(DrainingManaTag);
-		PlayerAbilitySystemRef->RemoveActiveEffectsWithGrantedTags(TagContainer);
+		return false;
 	}
 
-	
-	//Set defaults controls enemies
-	for (ARPGCharacterBase* CurrentEnemyRef : AbilityCurrentEnemyRefs)
+	//A read only lookup, a candidate without faction component is not an enemy
+	const URPGFactionComponent* CandidateFaction = Candidate->FindComponentByClass<URPGFactionComponent>();
+	const bool bIsEnemy = IsValid(CandidateFaction) && CandidateFaction->HasAnyFactionFlags(ERPGFactionFlags::Enemy);
+	return bIsEnemy && IsValidControlTarget(Candidate);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::GatherControlTargets(TArray<ARPGCharacterBase*>& OutTargets)
+{
+	const FVector PlayerLocation = PlayerCharacterReference->GetActorLocation();
+	if (bHasControlTargetsResult)
 	{
-		if (IsValid(CurrentEnemyRef))
+		for (const TWeakObjectPtr<ARPGCharacterBase>& CandidatePtr : ControlTargetCandidates)
 		{
-			//The NPC becomes again "Enemy", in case the project has actors with more tag, a better method of search and replacement should be made.
-			CurrentEnemyRef->Tags[0] = FName(TEXT("Enemy"));
+			ARPGCharacterBase* Candidate = CandidatePtr.Get();
+			if (IsQueriedControlTargetValid(Candidate, PlayerLocation))
+			{
+				OutTargets.Add(Candidate);
+			}
 		}
+		ResetControlTargetsQuery();
+		return;
 	}
 
-	//Destroy Hammers
-	for (ARPGTranscendenceHammer* CurrentHammerRef : AbilityCurrentHammersRefs)
+	ResetControlTargetsQuery();
+
+	//The overlap was not ready, a single grid query replaces it
+	URPGEnemySpatialGridSubsystem* EnemySpatialGrid = GetWorld()->GetSubsystem<URPGEnemySpatialGridSubsystem>();
+	if (IsValid(EnemySpatialGrid))
 	{
-		if (IsValid(CurrentHammerRef))
-		{
-			CurrentHammerRef->Destroy();
-		}
+		EnemySpatialGrid->GatherCharacters(PlayerLocation, ControlEnemiesRadius, ERPGFactionFlags::Enemy, AbilityControlledEnemiesSet,
+			[this](const ARPGCharacterBase* Candidate) { return IsValidControlTarget(Candidate); }, OutTargets);
 	}
+}
 
-	//Sanity Defaults
-	AbilityCurrentEnemyRefs.Empty();
-	AbilityCurrentHammersRefs.Empty();
-	bHasToSendHammerFire = false;
-	CurrentIndexHammerToUse = 0;
-	NextUseHammerIndexToUse = 0;
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-   BP_EndAbility();
+float URPGTranscendesAbility::ScoreVolleyTarget(const ARPGCharacterBase* Candidate, const FVector& PlayerLocation, const FVector& PlayerForward, const float MaxThreat) const
+{
+	const FVector ToCandidate = Candidate->GetActorLocation() - PlayerLocation;
+	const float Distance = ToCandidate.Size();
 
-   Super::EndAbility(Handle, ActorInfo, ActivationInfo, bReplicateEndAbility, bWasCancelled);
+	const float DistanceScore = ControlEnemiesRadius > 0.f ? 1.f - FMath::Clamp(Distance / ControlEnemiesRadius, 0.f, 1.f) : 0.f;
+	const float FacingScore = Distance > KINDA_SMALL_NUMBER ? (FVector::DotProduct(PlayerForward, ToCandidate / Distance) + 1.f) * 0.5f : 1.f;
+	const float ThreatScore = MaxThreat > 0.f ? Candidate->GetHealth() / MaxThreat : 0.f;
+
+	return DistanceScore * VolleyDistanceWeight + FacingScore * VolleyFacingWeight + ThreatScore * VolleyThreatWeight;
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-void URPGTranscendesAbility::OnManaChanged(const FOnAttributeChangeData& AttributeData)
+void URPGTranscendesAbility::SendHammerVolleyToControl()
 {
-	if (AttributeData.GEModData == nullptr)
+	RPG_TRANSCENDENCE_SCOPE(STAT_RPGTranscendence_SendHammerToControl);
+
+	TArray<ARPGCharacterBase*> VolleyTargets;
+	GatherControlTargets(VolleyTargets);
+
+	//Like a single use, the volley never sends the last hammer of the formation
+	const int32 NumUsableHammers = FormationHammerIndices.Num() - 1;
+	const int32 MaxTargets = MaxVolleyTargets > 0 ? FMath::Min(MaxVolleyTargets, NumUsableHammers) : NumUsableHammers;
+	const int32 NumTargets = FMath::Min(MaxTargets, VolleyTargets.Num());
+	if (NumTargets <= 0)
 	{
 		return;
 	}
 
-	const float ManaValue = AttributeData.NewValue;
+	struct FVolleyCandidate
+	{
+		ARPGCharacterBase* Character;
+		float Score;
+	};
 
-	if (ManaValue <= 0.f)
+	float MaxThreat = 0.f;
+	for (const ARPGCharacterBase* VolleyTarget : VolleyTargets)
 	{
-		EndAbility(CurrentSpecHandle, CurrentActorInfo, CurrentActivationInfo, true, false);
+		MaxThreat = FMath::Max(MaxThreat, VolleyTarget->GetHealth());
 	}
-}
-
-//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-void URPGTranscendesAbility::AddWaitGameplayEvent(const FGameplayTag& Tag)
-{
-	if (!Tag.IsValid())
+	const FVector PlayerLocation = PlayerCharacterReference->GetActorLocation();
+	const FVector PlayerForward = PlayerCharacterReference->GetActorForwardVector();
+	TArray<FVolleyCandidate> VolleyCandidates;
+	VolleyCandidates.Reserve(VolleyTargets.Num());
+	for (ARPGCharacterBase* VolleyTarget : VolleyTargets)
 	{
-		return;
+		VolleyCandidates.Add({ VolleyTarget, ScoreVolleyTarget(VolleyTarget, PlayerLocation, PlayerForward, MaxThreat) });
 	}
 
-	UAbilityTask_WaitGameplayEvent* WaitEventTask = UAbilityTask_WaitGameplayEvent::WaitGameplayEvent(this, Tag);
-	if (IsValid(WaitEventTask))
+	//Partial selection: only the K best candidates are popped from the heap, the rest is never sorted
+	const auto HigherScore = [](const FVolleyCandidate& A, const FVolleyCandidate& B) { return A.Score > B.Score; };
+	VolleyCandidates.Heapify(HigherScore);
+
+	//The first unused hammers of the formation go to the best ranked enemies
+	TArray<FRPGHammerUse> HammerUses;
+	HammerUses.Reserve(NumTargets);
+	for (int32 TargetIndex = 0; TargetIndex < NumTargets; TargetIndex++)
 	{
-		WaitEventTask->EventReceived.AddDynamic(this, &URPGTranscendesAbility::OnGameplayEventReceived);
-		WaitEventTask->ReadyForActivation();
+		FVolleyCandidate BestCandidate;
+		VolleyCandidates.HeapPop(BestCandidate, HigherScore, false);
+
+		FRPGHammerUse& HammerUse = HammerUses.AddDefaulted_GetRef();
+		HammerUse.HammerIndex = static_cast<uint8>(FormationHammerIndices[TargetIndex]);
+		HammerUse.EnemyRef = BestCandidate.Character;
+
+		AbilityCurrentEnemyRefs.Add(BestCandidate.Character);
+		AbilityControlledEnemiesSet.Add(BestCandidate.Character);
 	}
+
+	CommitHammerUses(HammerUses, true);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-void URPGTranscendesAbility::OnGameplayEventReceived(FGameplayEventData Payload)
+void URPGTranscendesAbility::ResetControlTargetsQuery()
 {
-    FGameplayTag CurrentEventTag = Payload.EventTag;
-	if (CurrentEventTag.IsValid())
-	{		
-		if (CurrentEventTag == TranscendenceCancelTag)
-		{
-			EndAbility(CurrentSpecHandle, CurrentActorInfo, CurrentActivationInfo, true, false);
-		}	
-
-		if (CurrentEventTag == StartFireProjectileHammerTag)
-		{
-		    bHasToSendHammerFire = true;
-			PreparetoUse();
-		}
-
-		if (CurrentEventTag == StartControlEnemyHammerTag)
-		{
-			PreparetoUse();
-		}
-    }
+	ControlTargetsQueryHandle = FTraceHandle();
+	ControlTargetCandidates.Reset();
+	bHasControlTargetsResult = false;
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-void URPGTranscendesAbility::SendHammerToControl()
+bool URPGTranscendesAbility::IsValidControlTarget(const ARPGCharacterBase* Candidate) const
 {
-	TArray<AActor*> ActorsToIgnore;
-	ActorsToIgnore.Add(PlayerCharacterReference);
-	ActorsToIgnore.Append(AbilityCurrentEnemyRefs);
+	if (Candidate == PlayerCharacterReference)
+	{
+		return false;
+	}
 
-	TArray<AActor*> OverlappedActors;
-	UKismetSystemLibrary::SphereOverlapActors(GetWorld() , PlayerCharacterReference->GetActorLocation() , ControlEnemiesRadius, ControlCollisionObjectTypes, ARPGCharacterBase::StaticClass() , ActorsToIgnore , OverlappedActors);
-	for (AActor* OverlappedActor : OverlappedActors)
+	//Same collision object filter used by the overlap query
+	const UPrimitiveComponent* CandidateRoot = Cast<UPrimitiveComponent>(Candidate->GetRootComponent());
+	if (!CandidateRoot || ControlCollisionObjectTypes.Num() == 0)
 	{
-		ARPGCharacterBase* OverlappedEnemy = Cast<ARPGCharacterBase>(OverlappedActor);
-		const bool bValidOverlappedEnemy = IsValid(OverlappedEnemy) && OverlappedEnemy->ActorHasTag(FName(TEXT("Enemy"))) && !AbilityCurrentEnemyRefs.Contains(OverlappedEnemy);
-		if (bValidOverlappedEnemy)
-		{
-			AbilityCurrentEnemyRefs.Add(OverlappedEnemy);
-			UseHammer(true , OverlappedEnemy);
-			break;
-		}
+		return true;
 	}
+
+	const EObjectTypeQuery CandidateObjectType = UEngineTypes::ConvertToObjectType(CandidateRoot->GetCollisionObjectType());
+	return ControlCollisionObjectTypes.Contains(CandidateObjectType);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 void URPGTranscendesAbility::PreparetoUse()
 {
+   if (!AbilityCurrentHammersRefs.IsValidIndex(CurrentIndexHammerToUse))
+   {
+      return;
+   }
+
+   //A hammer still waiting for spawn budget is acquired now, the player is about to use it
+   ServePendingAbilityHammer(CurrentIndexHammerToUse);
+
+   //Hammers still orbiting as instances have no actor until they are used
    ARPGTranscendenceHammer* CurrentHammerRef = AbilityCurrentHammersRefs[CurrentIndexHammerToUse];
-   if (!IsValid(CurrentHammerRef))
+   const bool bIsOrbitInstance = !IsValid(CurrentHammerRef) && IsOrbitInstance(CurrentIndexHammerToUse);
+   if (!IsValid(CurrentHammerRef) && !bIsOrbitInstance)
    {
       return;
    }
    
    //Is Player is valid state to use the next hammer
    UAnimMontage* MyCurrentMontage = PlayerCharacterReference->GetCurrentMontage();
-   const bool bIsNotPerfomingMontage = MyCurrentMontage != TranscendenceAttackFireMontage && MyCurrentMontage != TranscendenceAttackControlMontage;
-   const bool bIsValidState= (!CurrentHammerRef->GetIsPreparingToUse()) && !(CurrentIndexHammerToUse + 1 >= PlayerCharacterReference->GetAttributeSet()->GetNumberOfHammers());
+   const bool bIsNotPerfomingMontage = MyCurrentMontage != TranscendenceAttackFireMontage.Get() && MyCurrentMontage != TranscendenceAttackControlMontage.Get();
+   const bool bIsValidState= (bIsOrbitInstance || !CurrentHammerRef->GetIsPreparingToUse()) && !(CurrentIndexHammerToUse + 1 >= PlayerCharacterReference->GetAttributeSet()->GetNumberOfHammers());
    const bool bIsValidUse = bIsNotPerfomingMontage && bIsValidState;
    if (!bIsValidUse)
    {
@@ -255,11 +1171,14 @@ void URPGTranscendesAbility::PreparetoUse()
 
    if (bHasToSendHammerFire)
    {
-       PlayAbilityMontage(TranscendenceAttackFireMontage);
+       PlayAbilityMontage(TranscendenceAttackFireMontage.Get());
    }
    else
    {
-       PlayAbilityMontage(TranscendenceAttackControlMontage);
+       PlayAbilityMontage(TranscendenceAttackControlMontage.Get());
+
+	   //The targets are searched while the montage plays, the control event only picks the result
+	   RequestControlTargets();
    }
 
    //BP Event to switch VFX And visuals
@@ -270,43 +1189,122 @@ void URPGTranscendesAbility::PreparetoUse()
 
 void URPGTranscendesAbility::UseHammer(const bool bHasToControl, ARPGCharacterBase* EnemyRef)
 {
+	RPG_TRANSCENDENCE_SCOPE(STAT_RPGTranscendence_UseHammer);
+
 	if (bHasToControl && !EnemyRef)
 	{
 		return;
 	}
 
-    CurrentNumberOfHammers--;
-	int32 AuxAngleCalculateCounter = 1;
-	for (int i = 0 ; i <= AbilityCurrentHammersRefs.Num() -1  ; i++)
+	TArray<FRPGHammerUse> HammerUses;
+	FRPGHammerUse& HammerUse = HammerUses.AddDefaulted_GetRef();
+	HammerUse.HammerIndex = static_cast<uint8>(NextUseHammerIndexToUse);
+	HammerUse.EnemyRef = EnemyRef;
+
+	CommitHammerUses(HammerUses, bHasToControl);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void URPGTranscendesAbility::CommitHammerUses(const TArray<FRPGHammerUse>& HammerUses, const bool bHasToControl)
+{
+	if (ActivationRecord.TimeToFirstUseSeconds < 0.f && HammerUses.Num() > 0)
+	{
+		ActivationRecord.TimeToFirstUseSeconds = GetWorld()->GetTimeSeconds() - ActivationWorldTime;
+	}
+	if (bHasToControl)
+	{
+		ActivationRecord.NumControlUses += HammerUses.Num();
+	}
+	else
+	{
+		ActivationRecord.NumFireUses += HammerUses.Num();
+	}
+
+	//The actorless orbit only creates the actors of the hammers that are used, the budgeted spawn serves them at once
+	for (const FRPGHammerUse& HammerUse : HammerUses)
 	{
-	    ARPGTranscendenceHammer* HammerRef = AbilityCurrentHammersRefs[i];
-		if (IsValid(HammerRef))
+		ServePendingAbilityHammer(HammerUse.HammerIndex);
+		if (AbilityCurrentHammersRefs.IsValidIndex(HammerUse.HammerIndex) && !IsValid(AbilityCurrentHammersRefs[HammerUse.HammerIndex]))
 		{
-			if (NextUseHammerIndexToUse == i)
-			{
-				HammerRef->SetEnemyNPCRef(EnemyRef);
-				HammerRef->StartSpinningMode(true, bHasToControl, 0.f);
-				CurrentIndexHammerToUse = i;
-			}
-			else if (!HammerRef->GetWasHammerUsed())
-			{
-			    //Calculate the new hammer angle axis based on his current rotation direction
-				const float AngleAxisToCompare = ((360 / CurrentNumberOfHammers) - (360 / (CurrentNumberOfHammers + 1))) * AuxAngleCalculateCounter;
-				const float AnglesVariance = HammerRef->GetRotationDirection() > 0.f ? 360.f : 0;
-				const float NewAngleAxis = AngleAxisToCompare - AnglesVariance;
-				HammerRef->StartSpinningMode(false, false, NewAngleAxis);
-				AuxAngleCalculateCounter++;
-			}
-		}	
+			PromoteOrbitInstance(HammerUse.HammerIndex);
+		}
+	}
+
+	CurrentNumberOfHammers -= HammerUses.Num();
+	ApplyHammerUses(PlayerCharacterReference, AbilityCurrentHammersRefs, FormationHammerIndices, HammerUses, bHasToControl);
+
+	for (const FRPGHammerUse& HammerUse : HammerUses)
+	{
+		if (AbilityCurrentHammersRefs.IsValidIndex(HammerUse.HammerIndex) && IsValid(AbilityCurrentHammersRefs[HammerUse.HammerIndex]))
+		{
+			CurrentIndexHammerToUse = HammerUse.HammerIndex;
+		}
+		NextUseHammerIndexToUse = FMath::Max(NextUseHammerIndexToUse, HammerUse.HammerIndex + 1);
 	}
 
-	NextUseHammerIndexToUse++;
+	//The clients simulating the orbit apply the same uses to their local hammers
+	if (IsValid(OrbitReplicationComponent))
+	{
+		OrbitReplicationComponent->NotifyHammersUsed(HammerUses, bHasToControl);
+	}
 
 	BP_UseHammerEvent();
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
+void URPGTranscendesAbility::ApplyHammerUses(ARPGCharacterBase* OwnerCharacter, const TArray<ARPGTranscendenceHammer*>& Hammers, TArray<int32>& FormationHammerIndices, const TArray<FRPGHammerUse>& HammerUses, const bool bHasToControl)
+{
+	int32 NumUsedHammers = 0;
+	for (const FRPGHammerUse& HammerUse : HammerUses)
+	{
+		ARPGTranscendenceHammer* HammerToUse = Hammers.IsValidIndex(HammerUse.HammerIndex) ? Hammers[HammerUse.HammerIndex] : nullptr;
+		if (IsValid(HammerToUse))
+		{
+			HammerToUse->SetEnemyNPCRef(HammerUse.EnemyRef);
+			HammerToUse->StartSpinningMode(true, bHasToControl, 0.f);
+		}
+
+		//The used hammers leave the formation, the used ones are never visited again
+		NumUsedHammers += FormationHammerIndices.RemoveSingle(HammerUse.HammerIndex);
+	}
+
+	if (NumUsedHammers == 0)
+	{
+		return;
+	}
+
+	//Every remaining hammer moves to its slot of the smaller formation, the re-spacing is linear in the remaining hammers
+	URPGTranscendenceHammerSubsystem* OrbitSubsystem = IsValid(OwnerCharacter) ? OwnerCharacter->GetWorld()->GetSubsystem<URPGTranscendenceHammerSubsystem>() : nullptr;
+	const int32 RemainingNumberOfHammers = FormationHammerIndices.Num();
+	for (int32 RankIndex = 0; RankIndex < RemainingNumberOfHammers; RankIndex++)
+	{
+		//Rank 0 is the slot of the first used hammer, the remaining ones are spaced from it
+		const int32 FormationRank = RankIndex + 1;
+		const int32 HammerIndex = FormationHammerIndices[RankIndex];
+		ARPGTranscendenceHammer* HammerRef = Hammers.IsValidIndex(HammerIndex) ? Hammers[HammerIndex] : nullptr;
+		if (IsValid(HammerRef))
+		{
+		    //Calculate the new hammer angle axis based on his current rotation direction
+			const float NewAngleAxis = RPGHammerFormation::RelayoutAngleOffset(FormationRank, RemainingNumberOfHammers, HammerRef->GetRotationDirection(), NumUsedHammers);
+			HammerRef->StartSpinningMode(false, false, NewAngleAxis);
+		}
+		else if (IsValid(OrbitSubsystem))
+		{
+			//Unused hammers of the actorless orbit only have their orbit state
+			FRPGHammerOrbitState* InstanceOrbitState = OrbitSubsystem->FindOrbitState(OwnerCharacter, HammerIndex);
+			if (InstanceOrbitState && InstanceOrbitState->bIsInstance)
+			{
+				const float NewAngleAxis = RPGHammerFormation::RelayoutAngleOffset(FormationRank, RemainingNumberOfHammers, InstanceOrbitState->RotationDirection, NumUsedHammers);
+				OrbitSubsystem->StartOrbitSpinning(OwnerCharacter, HammerIndex, false, NewAngleAxis);
+			}
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
 bool URPGTranscendesAbility::PlayAbilityMontage(UAnimMontage* Montage, const float PlayRate /*= 1.f*/, const FName& StartSection /*= NAME_None*/, const bool bStopWhenAbilityEnds /*= true*/)
 {
 	if (!IsValid(Montage))
@@ -334,6 +1332,7 @@ bool URPGTranscendesAbility::PlayAbilityMontage(UAnimMontage* Montage, const flo
 
 void URPGTranscendesAbility::OnTranscendenceEffectRemoved(const FGameplayEffectRemovalInfo& GameplayEffectRemovalInfo)
 {
+	PendingEndReason = ERPGTranscendenceEndReason::EffectRemoved;
 	EndAbility(CurrentSpecHandle, CurrentActorInfo, CurrentActivationInfo, true, false);
 }
 
@@ -341,6 +1340,8 @@ void URPGTranscendesAbility::OnTranscendenceEffectRemoved(const FGameplayEffectR
 
 void URPGTranscendesAbility::OnMontageEventReceived(FGameplayTag EventTag, FGameplayEventData EventData)
 {
+	FRPGTelemetryCycleScope TelemetryScope(ActivationCycles);
+
 	if (EventTag.IsValid())
 	{
 		if (EventTag == TranscendenceAnimationEventFireTag)
@@ -351,7 +1352,113 @@ void URPGTranscendesAbility::OnMontageEventReceived(FGameplayTag EventTag, FGame
 
 		if (EventTag == TranscendenceAnimationEventControlTag)
 		{
-		    SendHammerToControl();
+			if (bUseControlVolley)
+			{
+				SendHammerVolleyToControl();
+			}
+			else
+			{
+				SendHammerToControl();
+			}
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+/**Loaded packages the asset package pulls in through hard references, the package itself included. Script and engine content stays resident anyway*/
+static void GatherLoadedDependencyPackages(const FName PackageName, IAssetRegistry& AssetRegistry, TSet<FName>& OutVisitedPackages, TArray<UPackage*>& OutLoadedPackages)
+{
+	bool bIsAlreadyVisited = false;
+	OutVisitedPackages.Add(PackageName, &bIsAlreadyVisited);
+	const FString PackagePath = PackageName.ToString();
+	if (bIsAlreadyVisited || PackagePath.StartsWith(TEXT("/Script/")) || PackagePath.StartsWith(TEXT("/Engine/")))
+	{
+		return;
+	}
+
+	UPackage* Package = FindPackage(nullptr, *PackagePath);
+	if (!Package)
+	{
+		return;
+	}
+	OutLoadedPackages.Add(Package);
+
+	TArray<FName> Dependencies;
+	AssetRegistry.GetDependencies(PackageName, Dependencies, UE::AssetRegistry::EDependencyCategory::Package, UE::AssetRegistry::EDependencyQuery::Hard);
+	for (const FName Dependency : Dependencies)
+	{
+		GatherLoadedDependencyPackages(Dependency, AssetRegistry, OutVisitedPackages, OutLoadedPackages);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static void ReportTranscendenceAssetMemory(UWorld* World)
+{
+	if (!World)
+	{
+		return;
+	}
+
+	//Characters of the world with and without a granted transcendence ability
+	int32 NumCharacters = 0;
+	int32 NumCharactersWithAbility = 0;
+	for (TActorIterator<ARPGCharacterBase> CharacterIterator(World); CharacterIterator; ++CharacterIterator)
+	{
+		NumCharacters++;
+		const UAbilitySystemComponent* AbilitySystem = CharacterIterator->GetAbilitySystemComponent();
+		const bool bHasAbility = AbilitySystem && AbilitySystem->GetActivatableAbilities().ContainsByPredicate([](const FGameplayAbilitySpec& AbilitySpec)
+		{
+			return AbilitySpec.Ability && AbilitySpec.Ability->IsA<URPGTranscendesAbility>();
+		});
+		NumCharactersWithAbility += bHasAbility ? 1 : 0;
+	}
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	for (TObjectIterator<UClass> ClassIterator; ClassIterator; ++ClassIterator)
+	{
+		if (!ClassIterator->IsChildOf<URPGTranscendesAbility>() || ClassIterator->HasAnyClassFlags(CLASS_Abstract | CLASS_NewerVersionExists))
+		{
+			continue;
+		}
+
+		TArray<FSoftObjectPath> AssetPaths;
+		ClassIterator->GetDefaultObject<URPGTranscendesAbility>()->GetTranscendenceAssetPaths(AssetPaths);
+
+		//Every streamed asset with what it pulls in, the meshes and materials of the hammer class included, each package counted once
+		TSet<FName> VisitedPackages;
+		int64 ResidentBytes = 0;
+		int32 NumLoadedPackages = 0;
+		for (const FSoftObjectPath& AssetPath : AssetPaths)
+		{
+			TArray<UPackage*> LoadedPackages;
+			GatherLoadedDependencyPackages(FName(*AssetPath.GetLongPackageName()), AssetRegistry, VisitedPackages, LoadedPackages);
+
+			FResourceSizeEx AssetResourceSize(EResourceSizeMode::EstimatedTotal);
+			for (UPackage* LoadedPackage : LoadedPackages)
+			{
+				ForEachObjectWithPackage(LoadedPackage, [&AssetResourceSize](UObject* PackageObject)
+				{
+					PackageObject->GetResourceSizeEx(AssetResourceSize);
+					return true;
+				}, false);
+			}
+
+			const int64 AssetBytes = AssetResourceSize.GetTotalMemoryBytes();
+			ResidentBytes += AssetBytes;
+			NumLoadedPackages += LoadedPackages.Num();
+
+			UE_LOG(LogRPGTranscendence, Display, TEXT("    %s: %d loaded packages, %.1f KB resident"), *AssetPath.ToString(), LoadedPackages.Num(), AssetBytes / 1024.0);
 		}
+
+		//The assets are loaded once per process, the saving only exists while no character in the process has the ability
+		UE_LOG(LogRPGTranscendence, Display, TEXT("%s: %d streamed assets, %d loaded packages, %.1f KB resident. Saved for the whole process while no character has the ability (%d of %d characters have it)"),
+			*ClassIterator->GetName(), AssetPaths.Num(), NumLoadedPackages, ResidentBytes / 1024.0, NumCharactersWithAbility, NumCharacters);
 	}
-}
\ No newline at end of file
+}
+
+static FAutoConsoleCommandWithWorld TranscendenceAssetMemoryReportCommand(
+	TEXT("RPG.Transcendence.AssetMemoryReport"),
+	TEXT("Lists the assets the transcendence abilities stream at grant and the resident size of their loaded dependencies, saved by the process while no character has the ability."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&ReportTranscendenceAssetMemory));
@@ -5,6 +5,10 @@
 #include "CoreMinimal.h"
 #include "Abilities/RPGGameplayAbility.h"
 #include "Abilities/RPGAbilitySystemComponent.h"
+#include "WorldCollision.h"
+#include "Engine/StreamableManager.h"
+#include "SergioTestContentClasses/RPGHammerOrbitReplicationComponent.h"
+#include "SergioTestContentClasses/RPGTranscendenceTelemetry.h"
 #include "RPGTranscendesAbility.generated.h"
 
 class ARPGCharacterBase;
@@ -12,6 +16,21 @@ class UAnimMontage;
 class URPGGameplayAbility;
 class URPGAbilityTask_PlayMontageAndWaitForEvent;
 class ARPGTranscendenceHammer;
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+
+/**A periodic effect draining or restoring mana, as seen by the depletion prediction*/
+struct FRPGManaDrainSource
+{
+	/**Seconds until the next execution of the effect*/
+	float TimeToNextTick = 0.f;
+
+	/**Seconds between executions*/
+	float Period = 0.f;
+
+	/**Mana removed by each execution, negative for a restore*/
+	float ManaPerTick = 0.f;
+};
 
 UCLASS()
 class ACTIONRPG_API URPGTranscendesAbility : public URPGGameplayAbility
@@ -29,9 +48,9 @@ protected:
    /** Player Character Ability System Ref*/
    UAbilitySystemComponent* PlayerAbilitySystemRef;
 
-   /**The Hammer Class to Use by Skill*/
+   /**The Hammer Class to Use by Skill, streamed when the ability is granted*/
    UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Properties")
-   TSubclassOf<ARPGTranscendenceHammer> HammerClassToSpawn;
+   TSoftClassPtr<ARPGTranscendenceHammer> HammerClassToSpawn;
    
    /**This Objtec type determines the collision channel filter during the ability to control and determine who enemy collides.*/
    UPROPERTY(EditDefaultsOnly, Category = "Properties")
@@ -45,21 +64,59 @@ protected:
    UPROPERTY(BlueprintReadOnly)
 	TArray<ARPGCharacterBase*> AbilityCurrentEnemyRefs;
 
+   /**Indices of the hammers not used yet in formation order, the re-layout only visits these*/
+   TArray<int32> FormationHammerIndices;
+
+   /**Same enemies as AbilityCurrentEnemyRefs, used as exclusion set by the control target search*/
+   TSet<const AActor*> AbilityControlledEnemiesSet;
+
+   /**The control use sends one hammer to each of the best ranked enemies in reach instead of only the nearest one*/
+   UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Properties|Volley")
+   uint8 bUseControlVolley : 1;
+
+   /**Maximum enemies controlled by one volley, 0 uses every remaining hammer but the last one, which always stays in orbit like with a single use*/
+   UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Properties|Volley", meta = (ClampMin = "0", EditCondition = "bUseControlVolley"))
+   int32 MaxVolleyTargets;
+
+   /**Weight of the volley ranking for the closer enemies*/
+   UPROPERTY(EditDefaultsOnly, Category = "Properties|Volley", meta = (EditCondition = "bUseControlVolley"))
+   float VolleyDistanceWeight;
+
+   /**Weight of the volley ranking for the enemies in front of the player*/
+   UPROPERTY(EditDefaultsOnly, Category = "Properties|Volley", meta = (EditCondition = "bUseControlVolley"))
+   float VolleyFacingWeight;
+
+   /**Weight of the volley ranking for the enemies with more health left*/
+   UPROPERTY(EditDefaultsOnly, Category = "Properties|Volley", meta = (EditCondition = "bUseControlVolley"))
+   float VolleyThreatWeight;
+
+   /**Async overlap issued when the control montage starts, consumed by the control animation event*/
+   FTraceHandle ControlTargetsQueryHandle;
+
+   /**Characters found by the last control overlap, validated again when they are consumed*/
+   TArray<TWeakObjectPtr<ARPGCharacterBase>> ControlTargetCandidates;
+
+   /**The control overlap finished and ControlTargetCandidates holds its result*/
+   uint8 bHasControlTargetsResult : 1;
+
    /** Montage Task */
    UPROPERTY()
    URPGAbilityTask_PlayMontageAndWaitForEvent* CurrentMontageTask;
 
-   /** Fire Hammer case montage reference */
+   /** Fire Hammer case montage reference, streamed when the ability is granted */
    UPROPERTY(EditDefaultsOnly, Category = "Properties|Animation")
-   UAnimMontage* TranscendenceAttackFireMontage;
+   TSoftObjectPtr<UAnimMontage> TranscendenceAttackFireMontage;
 
-   /** Control Hammer case montage reference */
+   /** Control Hammer case montage reference, streamed when the ability is granted */
    UPROPERTY(EditDefaultsOnly, Category = "Properties|Animation")
-   UAnimMontage* TranscendenceAttackControlMontage;
+   TSoftObjectPtr<UAnimMontage> TranscendenceAttackControlMontage;
 
-   /**Effect apply during the ability that determines is in transcendence state*/
+   /**Effect apply during the ability that determines is in transcendence state, streamed when the ability is granted*/
    UPROPERTY(EditDefaultsOnly, Category = "Properties|GAS")
-   TSubclassOf<UGameplayEffect> TranscendenceEffectSubclass;
+   TSoftClassPtr<UGameplayEffect> TranscendenceEffectSubclass;
+
+   /**Keeps the streamed hammer class, montages and effect in memory while the ability is granted*/
+   TSharedPtr<FStreamableHandle> TranscendenceAssetsHandle;
 
    /**Transcendence effect handle*/
    FActiveGameplayEffectHandle TranscendenceEffectHandle;
@@ -84,6 +141,13 @@ protected:
    UPROPERTY(EditDefaultsOnly, Category = "Properties|GAS")
    FGameplayTag DrainingManaTag;
 
+   /**Ends the ability at the moment the active drain effects are predicted to empty the mana*/
+   FTimerHandle ManaDepletionDeadlineHandle;
+
+   /**Bindings that recompute the deadline when a mana modifier is added or removed*/
+   FDelegateHandle DrainEffectAddedHandle;
+   FDelegateHandle DrainEffectRemovedHandle;
+
    /**Tag received by the montage to start the fire projectle process*/
    UPROPERTY(EditDefaultsOnly, Category = "Properties|GAS")
    FGameplayTag TranscendenceAnimationEventFireTag;
@@ -112,6 +176,48 @@ protected:
    UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Properties")
    float ControlEnemiesRadius;
 
+   /**Number of hammers added to the world pool when the ability was granted*/
+   int32 NumPrewarmedHammers;
+
+   /**How the hammers reach the clients, ClientSimulated only replicates the orbit descriptor and the use events*/
+   UPROPERTY(EditDefaultsOnly, Category = "Properties|Network")
+   ERPGHammerNetMode HammerNetMode;
+
+   /**Server component that replicates the orbit of this activation in ClientSimulated mode*/
+   UPROPERTY()
+   URPGHammerOrbitReplicationComponent* OrbitReplicationComponent;
+
+   /**Orbit the unused hammers as instances of one instanced mesh on the player, a hammer actor is only acquired when it is used*/
+   UPROPERTY(EditDefaultsOnly, Category = "Properties|Performance")
+   uint8 bUseActorlessOrbit : 1;
+
+   /**Mesh of the orbit instances, the same one the hammer actor shows*/
+   UPROPERTY(EditDefaultsOnly, Category = "Properties|Performance", meta = (EditCondition = "bUseActorlessOrbit"))
+   UStaticMesh* ActorlessOrbitMesh;
+
+   /**Instanced mesh on the player that displays the unused hammers in actorless orbit*/
+   UPROPERTY()
+   UInstancedStaticMeshComponent* OrbitInstancedMesh;
+
+   /**Seconds the hammers served by the budgeted spawn take to fade in when they join the orbit*/
+   UPROPERTY(EditDefaultsOnly, Category = "Properties|Performance")
+   float HammerFadeInSeconds;
+
+   /**Telemetry record of the current activation, submitted when it ends*/
+   FRPGTranscendenceActivationRecord ActivationRecord;
+
+   /**Game thread time of the ability code during the current activation*/
+   FRPGTelemetryCycleCounter ActivationCycles;
+
+   /**World time of the activation, origin of the duration and of the time to the first use*/
+   float ActivationWorldTime;
+
+   /**Set by the end paths before calling EndAbility, Ended when the end has no specific reason*/
+   ERPGTranscendenceEndReason PendingEndReason;
+
+   /**An activation record is open, only the first EndAbility of the activation submits it*/
+   uint8 bIsRecordingActivation : 1;
+
 protected:
 
     /**Generic custom function to receive events and identify them with the tag*/
@@ -126,8 +232,39 @@ protected:
 	UFUNCTION()
 	void OnMontageEventReceived(FGameplayTag EventTag, FGameplayEventData EventData);
 
-	/** Called every time the mana atributte change and take control of the process */
-	void OnManaChanged(const FOnAttributeChangeData& AttributeData);
+	/** Called once when the mana atributte reaches zero and take control of the process */
+	void OnManaDepleted(float NewManaValue);
+
+	/**Predict when the drain effects empty the mana and schedule the end of the ability at that moment*/
+	void ScheduleManaDepletionDeadline();
+
+	/**Called at the predicted depletion, ends the ability or reschedules if the mana changed since the prediction*/
+	void OnManaDepletionDeadline();
+
+	/**Periodic effects of the player currently draining (owning DrainingManaTag) or restoring mana*/
+	void GatherManaDrainSources(TArray<FRPGManaDrainSource>& OutDrainSources) const;
+
+	/**Mana removed per execution of the periodic effect, negative for a restore, 0 if it does not count for the prediction (drain without DrainingManaTag)*/
+	float GetManaPerTick(const FGameplayEffectSpec& Spec) const;
+
+	/**Does the effect change the depletion prediction, a periodic drain owning DrainingManaTag or a periodic restore*/
+	bool IsManaDrainSpec(const FGameplayEffectSpec& Spec) const;
+
+	void OnDrainEffectAdded(UAbilitySystemComponent* AbilitySystem, const FGameplayEffectSpec& Spec, FActiveGameplayEffectHandle ActiveHandle);
+
+	void OnDrainEffectRemoved(const FActiveGameplayEffect& RemovedEffect);
+
+	/**Stop the deadline and the drain rate bindings*/
+	void ClearManaDepletionDeadline();
+
+	/**Seconds until the drain sources bring the mana to zero, negative if they never do. Restores are capped at MaxMana*/
+	static float PredictManaDepletionDelay(const float CurrentMana, const float MaxMana, const TArray<FRPGManaDrainSource>& DrainSources);
+
+	/**Stream the ability assets and pre-warm the hammer pool when the ability is granted*/
+	virtual void OnGiveAbility(const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilitySpec& Spec) override;
+
+	/**Release the pre-warmed hammers and the streamed assets when the ability is removed*/
+	virtual void OnRemoveAbility(const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilitySpec& Spec) override;
 
 	/**Activate Ability Function*/
     virtual void ActivateAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, const FGameplayEventData* TriggerEventData) override;
@@ -135,6 +272,24 @@ protected:
 	/**End Ability Function*/
 	virtual void EndAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, bool bReplicateEndAbility, bool bWasCancelled) override;
 
+	/**Open the telemetry record of an activation that passed its checks*/
+	void BeginActivationRecord(const FGameplayAbilityActivationInfo& ActivationInfo);
+
+	/**Complete the record with the end reason and the orbit telemetry and queue it for the telemetry writer*/
+	void FinishActivationRecord(const bool bWasCancelled);
+
+	/**Start streaming the hammer class, montages and effect if they are not requested yet*/
+	void RequestTranscendenceAssets();
+
+	/**The streamed assets arrived, pre-warm the hammers of the granted ability*/
+	void OnTranscendenceAssetsLoaded();
+
+	/**Every asset the activation needs is in memory, the activation is refused until then*/
+	bool AreTranscendenceAssetsLoaded() const;
+
+	/**Loaded hammer class, nullptr until the grant streaming finished*/
+	TSubclassOf<ARPGTranscendenceHammer> GetHammerClass() const { return HammerClassToSpawn.Get(); }
+
 	/** Play Ability Any Montage and bind the respectic Params*/
 	bool PlayAbilityMontage(UAnimMontage* Montage, const float PlayRate = 1.f, const FName& StartSection = NAME_None, const bool bStopWhenAbilityEnds = true);
 
@@ -147,11 +302,74 @@ protected:
 	/**Start the process of hammer enemy control*/
 	void SendHammerToControl();
 
+	/**Control volley: one query, rank the candidates and send the remaining hammers to the top ones in a single use*/
+	void SendHammerVolleyToControl();
+
+	/**Every valid control candidate of the async overlap, or of the spatial grid when the overlap is not usable*/
+	void GatherControlTargets(TArray<ARPGCharacterBase*>& OutTargets);
+
+	/**Volley ranking of a candidate, higher is better*/
+	float ScoreVolleyTarget(const ARPGCharacterBase* Candidate, const FVector& PlayerLocation, const FVector& PlayerForward, const float MaxThreat) const;
+
+	/**Is the candidate of the async overlap still a valid target now*/
+	bool IsQueriedControlTargetValid(const ARPGCharacterBase* Candidate, const FVector& PlayerLocation) const;
+
+	/**Start the async overlap of the control candidates at the beginning of the control montage*/
+	void RequestControlTargets();
+
+	/**Async overlap callback, stores the candidates of the current request*/
+	void OnControlTargetsQueryCompleted(const FTraceHandle& TraceHandle, FOverlapDatum& OverlapDatum);
+
+	/**Nearest candidate of the async overlap that is still a valid target, nullptr if the result is not ready or nobody is left*/
+	ARPGCharacterBase* TakeQueriedControlTarget();
+
+	/**Forget the pending control overlap and its candidates*/
+	void ResetControlTargetsQuery();
+
+	/**Is the candidate an enemy that can be controlled by the hammers*/
+	bool IsValidControlTarget(const ARPGCharacterBase* Candidate) const;
+
 	/** Use the hammer*/
 	void UseHammer(const bool bHasToControl , ARPGCharacterBase* EnemyRef);
 
+	/**Commit every hammer of the uses together, with a single re-layout of the remaining hammers*/
+	void CommitHammerUses(const TArray<FRPGHammerUse>& HammerUses, const bool bHasToControl);
+
+	/**Acquire the hammer actor of the index from the pool with the replication of the current net mode*/
+	ARPGTranscendenceHammer* AcquireAbilityHammer(const int32 HammerIndex, const float InitialAngleAxis);
+
+	/**Match the replication of a pooled hammer with the net mode of this ability*/
+	void ApplyAbilityNetMode(ARPGTranscendenceHammer* Hammer) const;
+
+	/**Request every hammer of the activation to the pool, they join the orbit over the next frames within the spawn budget*/
+	void RequestAbilityHammers();
+
+	/**A requested hammer arrived, put it in its slot aligned with the hammers already orbiting*/
+	void OnAbilityHammerAcquired(ARPGTranscendenceHammer* Hammer, const int32 HammerIndex);
+
+	/**The hammer index is about to be used, acquire it now if its request is still waiting for budget*/
+	void ServePendingAbilityHammer(const int32 HammerIndex);
+
+	/**Start the actorless orbit, one instance per hammer index*/
+	void SpawnOrbitInstances();
+
+	/**Replace the orbit instance of the index by a hammer actor that continues from the same orbit state*/
+	ARPGTranscendenceHammer* PromoteOrbitInstance(const int32 HammerIndex);
+
+	/**Is the hammer index still orbiting as an instance*/
+	bool IsOrbitInstance(const int32 HammerIndex) const;
+
 public:
 
+	/**Soft references streamed at grant, shared by the load request and the memory report*/
+	void GetTranscendenceAssetPaths(TArray<FSoftObjectPath>& OutAssetPaths) const;
+
+	/**
+	 * Start spinning the used hammers and re-layout the remaining ones in one pass, shared by the ability and the clients simulating its hammers.
+	 * FormationHammerIndices holds the unused hammer indices in formation order, the used ones are removed from it.
+	 */
+	static void ApplyHammerUses(ARPGCharacterBase* OwnerCharacter, const TArray<ARPGTranscendenceHammer*>& Hammers, TArray<int32>& FormationHammerIndices, const TArray<FRPGHammerUse>& HammerUses, const bool bHasToControl);
+
 	UFUNCTION(BlueprintImplementableEvent)
 	void BP_EndAbility();
 